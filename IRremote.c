@@ -19,7 +19,7 @@
 
 #include "IRremote.h"
 
-struct irparams_struct irparams; // the irparams instance
+ir_receiver_t IR_defaultReceiver = { .hw = IR_RECEIVER_HW_DEFAULT }; // the receiver of the IR_* functions
 
 
 //+=============================================================================
@@ -34,7 +34,9 @@ struct irparams_struct irparams; // the irparams instance
 // I may revisit this code at a later date and look at the assembler produced
 //   in a hope of finding out what is going on, but for now they will remain as
 //   functions even in non-DEBUG mode
+// Without DEBUG they are inline in IRremote.h again, these trace every comparison.
 //
+#ifdef DEBUG
 int MATCH(unsigned int measured, unsigned int desired) {
     bool passed = ((measured >= TICKS_LOW(desired)) && (measured <= TICKS_HIGH(desired)));
 #if DEBUG
@@ -79,6 +81,313 @@ int MATCH_SPACE(uint16_t measured_ticks, unsigned int desired_us) {
 #endif
     return passed;
 }
+#endif // DEBUG
+
+//+=============================================================================
+// Frame hand over helpers, used from the ISR only.
+// The ISR always writes into the capture slot. When a frame is complete it is
+// committed (head++) and capturing continues in the next slot, unless the ring
+// is full. In that case the ISR switches to STOP and drops incoming frames
+// (counting them) until IR_resume() has released a slot.
+//
+// Count the entries of the frame and follow them with the end of frame predictor,
+// the frame itself is not at hand with the edge FIFO
+static inline void trackEntry(struct irparams_struct *params, uint16_t ticks) {
+#ifdef USE_IR_EARLY_FRAME_END
+    IR_streamTrack(&params->frameEnd, params->frameEntries, ticks);
+#else
+    (void)ticks;
+#endif
+    params->frameEntries++;
+}
+
+// Enclose every update of params->stats, see IR_receiverGetStats()
+static inline void beginStats(struct irparams_struct *params) {
+    params->stats.sequence++;
+    __DMB();
+}
+
+static inline void endStats(struct irparams_struct *params) {
+    __DMB();
+    params->stats.sequence++;
+}
+
+#ifdef USE_IR_EDGE_FIFO
+// With the edge FIFO the durations go straight to the decoder task.
+// The ISR never stops, entries which do not fit are counted as overruns.
+static inline bool frameRingFull(struct irparams_struct *params) {
+    (void)params;
+    return false;
+}
+
+#ifdef USE_IR_LONG_FRAMES
+// The long frame decoder follows every frame unless it still holds one for the decoder task
+static inline ir_long_frame_decoder* longFrame(struct irparams_struct *params) {
+    return params->longFrameReady ? NULL : params->longFrame;
+}
+#endif
+
+static inline void pushGap(struct irparams_struct *params, uint16_t gap) {
+    IR_edgeFifoPush(&params->edges, (gap > IR_EDGE_MAX_DURATION ? IR_EDGE_MAX_DURATION : gap) | IR_EDGE_FRAME_START);
+#ifdef USE_IR_LONG_FRAMES
+    ir_long_frame_decoder *decoder = longFrame(params);
+    if (decoder) {
+        IR_longFrameReset(decoder);
+        IR_longFrameFeed(decoder, gap);
+    }
+#endif
+}
+
+static inline void pushDuration(struct irparams_struct *params, uint16_t ticks) {
+    trackEntry(params, ticks);
+    // One entry beyond rawbuf tells the decoder task that the frame overflowed
+    if (params->frameEntries <= RAW_BUFFER_LENGTH + 1) {
+        IR_edgeFifoPush(&params->edges, ticks > IR_EDGE_MAX_DURATION ? IR_EDGE_MAX_DURATION : ticks);
+    }
+#ifdef USE_IR_LONG_FRAMES
+    ir_long_frame_decoder *decoder = longFrame(params);
+    if (decoder) {
+        IR_longFrameFeed(decoder, ticks);
+    }
+#endif
+}
+
+static inline void pushCommit(struct irparams_struct *params) {
+#ifdef USE_IR_LONG_FRAMES
+    ir_long_frame_decoder *decoder = longFrame(params);
+    if (decoder && IR_longFrameComplete(decoder)) {
+        // Kept until IR_resume(), set before the token makes it visible
+        params->longFrameReady = true;
+        if (!IR_edgeFifoPush(&params->edges, IR_EDGE_LONG_FRAME_END)) {
+            params->longFrameReady = false; // lost to an overrun like any other frame
+        }
+    } else
+#endif
+    IR_edgeFifoPush(&params->edges, IR_EDGE_FRAME_END);
+    params->head++; // only counts, there is no ring
+    params->rcvstate = IR_REC_STATE_IDLE;
+}
+#else
+static inline bool frameRingFull(struct irparams_struct *params) {
+    return IR_FRAMES_PENDING(params) >= IR_FRAME_RING_LENGTH;
+}
+
+static inline void pushGap(struct irparams_struct *params, uint16_t gap) {
+    struct irframe_struct *frame = IR_CAPTURE_FRAME(params);
+    frame->overflow = false;
+    IR_rawStore(frame, 0, gap);
+    frame->rawlen = 1;
+}
+
+static inline void pushDuration(struct irparams_struct *params, uint16_t ticks) {
+    struct irframe_struct *frame = IR_CAPTURE_FRAME(params);
+    trackEntry(params, ticks);
+    if (frame->rawlen < RAW_BUFFER_LENGTH) {
+        IR_rawStore(frame, frame->rawlen++, ticks);
+    } else {
+        // Flag up a read overflow; Keep the frame until the gap
+        frame->overflow = true;
+    }
+}
+
+static inline void pushCommit(struct irparams_struct *params) {
+    params->head++;
+    params->rcvstate = frameRingFull(params) ? IR_REC_STATE_STOP : IR_REC_STATE_IDLE;
+}
+#endif // USE_IR_EDGE_FIFO
+
+// Start a new frame with the gap before it
+static inline void startFrame(struct irparams_struct *params, uint16_t gap) {
+    params->frameEntries = 0;
+#ifdef IR_MIN_PULSE_MICROS
+    params->holding = false;
+    params->merging = false;
+#endif
+    trackEntry(params, gap);
+    pushGap(params, gap);
+}
+
+#ifdef IR_MIN_PULSE_MICROS
+//+=============================================================================
+// Glitch filter.
+// The latest duration is held back until the next one is known. A duration
+// shorter than IR_MIN_PULSE_TICKS is a spike, it is merged together with the
+// following duration into the held one: mark, spike, mark becomes one mark.
+// Returns true if ticks is kept as an entry of its own.
+//
+static inline bool storeDuration(struct irparams_struct *params, uint16_t ticks) {
+    if (params->merging || (params->holding && ticks < IR_MIN_PULSE_TICKS)) {
+        uint32_t merged = (uint32_t)params->held + ticks;
+        params->held = merged > 0xFFFF ? 0xFFFF : merged;
+        params->merging = !params->merging;
+        return false;
+    }
+    if (params->holding) {
+        pushDuration(params, params->held);
+    }
+    params->held = ticks;
+    params->holding = true;
+    return true;
+}
+
+static inline void flushDuration(struct irparams_struct *params) {
+    if (params->holding) {
+        pushDuration(params, params->held);
+        params->holding = false;
+    }
+}
+#else
+static inline bool storeDuration(struct irparams_struct *params, uint16_t ticks) {
+    pushDuration(params, ticks);
+    return true;
+}
+
+static inline void flushDuration(struct irparams_struct *params) {
+    (void)params;
+}
+#endif // IR_MIN_PULSE_MICROS
+
+static inline void commitFrame(struct irparams_struct *params) {
+    flushDuration(params);
+    beginStats(params);
+    params->stats.frames++;
+    params->stats.edges += params->frameEntries;
+    endStats(params);
+    pushCommit(params);
+}
+
+#ifdef USE_IR_EARLY_FRAME_END
+// Number of entries of the current frame, including the gap and a held duration
+static inline uint16_t frameEntries(struct irparams_struct *params) {
+#ifdef IR_MIN_PULSE_MICROS
+    return params->frameEntries + params->holding;
+#else
+    return params->frameEntries;
+#endif
+}
+#endif
+
+// Returns true if the decoder has got something to do
+static inline bool framesPending(struct irparams_struct *params) {
+#ifdef USE_IR_EDGE_FIFO
+    return params->edges.head != params->edges.tail;
+#else
+    return IR_FRAMES_PENDING(params) != 0;
+#endif
+}
+
+#ifdef USE_IR_EARLY_FRAME_END
+// A frame the long frame decoder still follows may go on, only the gap ends it
+static inline bool longFrameLive(struct irparams_struct *params) {
+#ifdef USE_IR_LONG_FRAMES
+    ir_long_frame_decoder *decoder = longFrame(params);
+    return decoder && decoder->live;
+#else
+    (void)params;
+    return false;
+#endif
+}
+#endif
+
+// Called when a mark has ended, the receiver is timing a space afterwards.
+// If the mark completes a frame of a known protocol, the frame is committed right away.
+static inline void storeMark(struct irparams_struct *params, uint16_t ticks) {
+    bool stored = storeDuration(params, ticks);
+    params->rcvstate = IR_REC_STATE_SPACE;
+#ifdef USE_IR_EARLY_FRAME_END
+    if (stored && !longFrameLive(params) && IR_streamFrameComplete(&params->frameEnd, params->frameEntries, frameEntries(params), ticks)) {
+        commitFrame(params);
+    }
+#else
+    (void)stored;
+#endif
+}
+
+// Tell the application that a frame was committed
+static inline void notifyFrame(ir_receiver_t *receiver) {
+    if (receiver->frameCallback) {
+        receiver->frameCallback(receiver);
+    }
+    if (receiver->notifyThread) {
+        osSignalSet(receiver->notifyThread, receiver->notifySignals);
+    }
+}
+
+// Called in state STOP when a frame starts. It is discarded and counted once.
+static inline void dropFrameStart(struct irparams_struct *params) {
+    if (!params->dropping) {
+        params->dropping = true;
+        beginStats(params);
+        params->stats.dropped++;
+        endStats(params);
+    }
+}
+
+// Called in state STOP if a gap was detected
+static inline void dropFrameEnd(struct irparams_struct *params) {
+    params->dropping = false;
+    if (!frameRingFull(params)) {
+        params->rcvstate = IR_REC_STATE_IDLE;
+    }
+}
+
+#ifdef IR_STORM_EDGES
+//+=============================================================================
+// Interrupt storm protection.
+// Counts the edges per IR_STORM_WINDOW_MS. If there are too many, the frame in
+// progress is discarded, the backoff starts and true is returned. The caller
+// masks the capture interrupts then and polls stormOver() from the timer.
+//
+static inline bool stormDetected(struct irparams_struct *params) {
+    uint32_t now = millis();
+
+    if (now - params->stormTime >= IR_STORM_WINDOW_MS) {
+        // The last window was calm, the next storm starts with the shortest backoff again
+        params->stormTime = now;
+        params->stormEdges = 0;
+        params->stormBackoff = IR_STORM_BACKOFF_MS;
+    }
+    if (++params->stormEdges <= IR_STORM_EDGES) {
+        return false;
+    }
+
+    beginStats(params);
+    params->stats.storms++;
+    endStats(params);
+    params->storming = true;
+    params->stormTime = now + params->stormBackoff;
+    params->stormBackoff = params->stormBackoff < IR_STORM_BACKOFF_MAX_MS / 2 ? params->stormBackoff * 2 : IR_STORM_BACKOFF_MAX_MS;
+    params->dropping = false;
+    params->rcvstate = frameRingFull(params) ? IR_REC_STATE_STOP : IR_REC_STATE_IDLE;
+    return true;
+}
+
+// Returns true once the backoff has passed, the edges are counted in a new window then
+static inline bool stormOver(struct irparams_struct *params) {
+    uint32_t now = millis();
+
+    if ((int32_t)(now - params->stormTime) < 0) {
+        return false;
+    }
+    params->storming = false;
+    params->stormTime = now;
+    params->stormEdges = 0;
+    return true;
+}
+
+static inline void maskCaptureIT(TIM_TypeDef *TIMx) {
+    LL_TIM_DisableIT_CC1(TIMx);
+    LL_TIM_DisableIT_CC2(TIMx);
+}
+
+// Captures taken during the backoff are stale
+static inline void unmaskCaptureIT(TIM_TypeDef *TIMx) {
+    LL_TIM_ClearFlag_CC1(TIMx);
+    LL_TIM_ClearFlag_CC2(TIMx);
+    LL_TIM_EnableIT_CC1(TIMx);
+    LL_TIM_EnableIT_CC2(TIMx);
+}
+#endif // IR_STORM_EDGES
 
 //+=============================================================================
 // Receive timer interrupt handlers to collect raw data.
@@ -86,34 +395,319 @@ int MATCH_SPACE(uint16_t measured_ticks, unsigned int desired_us) {
 // 'rawlen' counts the number of entries recorded so far.
 // First entry is the SPACE between transmissions.
 // As soon as a the first [SPACE] entry gets long:
-//   Ready is set; State switches to IDLE; Timing of SPACE continues.
+//   Frame is committed to the ring; State switches to IDLE; Timing of SPACE continues.
 // As soon as first MARK arrives:
-//   Gap width is recorded; Ready is cleared; New logging starts
+//   Gap width is recorded; New logging starts in the next free slot
+
+#if defined(USE_TIMER_DMA_MODE)
+//+=============================================================================
+// Convert a batch of edge timestamps into durations and cut them into frames.
+// The timer runs free at 1 MHz, so a duration is the wrapping difference of two timestamps.
+// Edges alternate between falling (mark starts) and rising (space starts), and the
+// first edge after a gap always starts a mark, since the receiver output is idle high.
+// The captures do not tell the edges apart, so dmaMark keeps track of the level,
+// also while frames are dropped.
+// A space longer than GAP_TICKS ends the frame, so several frames within one
+// batch are separated here. A mark that long (the 9 ms NEC header) does not.
+// The end of the last frame is found by the timeout.
+//
+static void convertTimestamps(struct irparams_struct *params, const uint16_t *timestamps, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t ticks = (uint16_t)(timestamps[i] - params->lastEdge) / MICROS_PER_TICK;
+        params->lastEdge = timestamps[i];
+        if (params->dmaLongGap) {
+            // The counter has come round since the last edge, the difference wrapped
+            params->dmaLongGap = false;
+            ticks = 0xFFFF;
+        }
+
+        if (ticks > GAP_TICKS && !params->dmaMark) {
+            // A long Space, the edge starts a new code
+            if (params->rcvstate == IR_REC_STATE_SPACE) {
+                commitFrame(params);
+            } else if (params->rcvstate == IR_REC_STATE_STOP) {
+                dropFrameEnd(params);
+            }
+        }
+        params->dmaMark = !params->dmaMark;
 
-#ifdef USE_TIMER_IC_MODE
+        if (params->rcvstate == IR_REC_STATE_IDLE) {
+            startFrame(params, ticks);
+            params->rcvstate = IR_REC_STATE_MARK;
+        } else if (params->rcvstate == IR_REC_STATE_MARK) {
+            storeMark(params, ticks);
+        } else if (params->rcvstate == IR_REC_STATE_SPACE) {
+            storeDuration(params, ticks);
+            params->rcvstate = IR_REC_STATE_MARK;
+        } else {
+            dropFrameStart(params);
+        }
+    }
+}
+
+// Convert all timestamps the DMA has written since the last call.
+// The write position is derived from the remaining transfer count of the circular channel.
+static void drainTimestamps(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    uint16_t write = IR_DMA_BUFFER_LENGTH - LL_DMA_GetDataLength(receiver->hw.dma, receiver->hw.dmaChannel);
+
+    if (write < params->dmaRead) {
+        convertTimestamps(params, &params->timestamps[params->dmaRead], IR_DMA_BUFFER_LENGTH - params->dmaRead);
+        params->dmaRead = 0;
+    }
+    convertTimestamps(params, &params->timestamps[params->dmaRead], write - params->dmaRead);
+    params->dmaRead = write;
+}
+
+// Convert the pending timestamps and commit the frame if its last space has reached _GAP.
+// Then wait for the first edge of the next frame, or arm the end of frame timeout:
+// _GAP after the last edge in a space, and _GAP from now to look again while a mark is running.
+//
+static void serviceTimestamps(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    TIM_TypeDef *TIMx = receiver->hw.tim;
+    // Read before the drain, so every edge up to here is in the buffer
+    bool idle = IR_READPIN(&receiver->hw) == SPACE;
+
+    drainTimestamps(receiver);
+
+    if ((uint16_t)(LL_TIM_GetCounter(TIMx) - params->lastEdge) >= _GAP) {
+        // No edge since _GAP. The input level is stable then, it also gets
+        // dmaMark right again if an edge was ever lost.
+        params->dmaMark = !idle;
+        if (params->dmaMark) {
+            // A long mark, the frame goes on
+        } else if (params->rcvstate == IR_REC_STATE_MARK || params->rcvstate == IR_REC_STATE_SPACE) {
+            // A long Space, indicates gap between codes
+            commitFrame(params);
+        } else if (params->rcvstate == IR_REC_STATE_STOP) {
+            dropFrameEnd(params);
+        }
+    }
+
+    if (params->rcvstate == IR_REC_STATE_IDLE
+            || (params->rcvstate == IR_REC_STATE_STOP && !params->dropping)) {
+        LL_TIM_ClearFlag_CC2(TIMx);
+        LL_TIM_EnableIT_CC2(TIMx);
+        if (params->dmaLongGap) {
+            LL_TIM_DisableIT_CC3(TIMx);
+        } else {
+            // Fires when the counter comes round to the last edge, the gap no longer fits into 16 bit then
+            LL_TIM_OC_SetCompareCH3(TIMx, params->lastEdge);
+            LL_TIM_ClearFlag_CC3(TIMx);
+            LL_TIM_EnableIT_CC3(TIMx);
+        }
+    } else {
+        LL_TIM_DisableIT_CC2(TIMx);
+        LL_TIM_OC_SetCompareCH3(TIMx, (uint16_t)((params->dmaMark ? LL_TIM_GetCounter(TIMx) : params->lastEdge) + _GAP));
+        LL_TIM_ClearFlag_CC3(TIMx);
+        LL_TIM_EnableIT_CC3(TIMx);
+    }
+}
+
+// Timer DMA mode IRQ handler.
+// Fires on the first edge of a frame (CC2), on the end of frame timeout (CC3) and,
+// while waiting for a frame, once the gap has reached a full counter period (CC3).
+//
+static inline void timerDMAHandler(ir_receiver_t *receiver) {
+    TIM_TypeDef *TIMx = receiver->hw.tim;
+
+    if (LL_TIM_IsEnabledIT_CC2(TIMx) && LL_TIM_IsActiveFlag_CC3(TIMx)) {
+        receiver->params.dmaLongGap = true;
+    }
+    LL_TIM_ClearFlag_CC2(TIMx);
+    LL_TIM_ClearFlag_CC3(TIMx);
+    serviceTimestamps(receiver);
+}
+
+//+=============================================================================
+// DMA half/full transfer IRQ handler, keeps the circular buffer from being overrun.
+// Must run at the same interrupt priority as the timer IRQ handler of the receiver.
+//
+bool IR_receiverDMAIRQHandler(ir_receiver_t *receiver) {
+    IR_PROFILE_BEGIN(start);
+    uint8_t committed = receiver->params.head;
+
+    IR_dmaClearFlags(&receiver->hw);
+    serviceTimestamps(receiver);
+
+    if (receiver->params.head != committed) {
+        notifyFrame(receiver);
+    }
+    IR_PROFILE_END(IR_PROFILE_DMA_ISR, start);
+    return framesPending(&receiver->params);
+}
+
+bool IR_DMAIRQHandler(void) {
+    return IR_receiverDMAIRQHandler(&IR_defaultReceiver);
+}
+
+#elif defined(USE_TIMER_IC_FREE_RUNNING)
+//+=============================================================================
+// Extend a capture of the free running 16 bit counter by the software overflow count.
+// If an overflow is still pending, it happened before the capture if the
+// captured value is in the lower half of the counter range.
+//
+static inline uint32_t extendCapture(struct irparams_struct *params, TIM_TypeDef *TIMx, uint16_t ccr) {
+    uint32_t overflows = params->overflows;
+    if (LL_TIM_IsActiveFlag_UPDATE(TIMx) && ccr < 0x8000) {
+        overflows++;
+    }
+    return (overflows << 16) | ccr;
+}
+
+// Duration since the previous edge, clipped to what fits into rawbuf
+static inline uint16_t captureDuration(struct irparams_struct *params, TIM_TypeDef *TIMx, uint16_t ccr) {
+    uint32_t capture = extendCapture(params, TIMx, ccr);
+    uint32_t ticks = (capture - params->lastCapture) / MICROS_PER_TICK;
+    params->lastCapture = capture;
+    return ticks > 0xFFFF ? 0xFFFF : ticks;
+}
+
+// Start the end of frame timeout _GAP after the edge captured at ccr.
+// Only a space ends a frame, so it runs from a rising edge and is off during a mark.
+static inline void armGapTimeout(TIM_TypeDef *TIMx, uint16_t ccr) {
+    LL_TIM_OC_SetCompareCH3(TIMx, (uint16_t)(ccr + _GAP));
+    LL_TIM_ClearFlag_CC3(TIMx);
+    LL_TIM_EnableIT_CC3(TIMx);
+}
+
+// No edge since _GAP, indicates gap between codes
+static inline void gapDetected(struct irparams_struct *params) {
+    if (params->rcvstate == IR_REC_STATE_MARK || params->rcvstate == IR_REC_STATE_SPACE) {
+        commitFrame(params);
+    } else if (params->rcvstate == IR_REC_STATE_STOP) {
+        dropFrameEnd(params);
+    }
+}
+
+// Free running Timer Input Capture mode IRQ handler.
+// Fires on Rising edge, Falling edge, end of frame timeout (CC3) and Overflow.
+// The counter is never written, the captures are taken as they are.
+//
+static inline void timerFreeRunningHandler(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    TIM_TypeDef *TIMx = receiver->hw.tim;
+
+#ifdef IR_STORM_EDGES
+    if (params->storming) {
+        // Capture interrupts are masked, CC3 polls the end of the backoff every _GAP
+        if (LL_TIM_IsActiveFlag_UPDATE(TIMx)) {
+            LL_TIM_ClearFlag_UPDATE(TIMx);
+            params->overflows++;
+        }
+        if (LL_TIM_IsActiveFlag_CC3(TIMx)) {
+            LL_TIM_ClearFlag_CC3(TIMx);
+            if (stormOver(params)) {
+                LL_TIM_DisableIT_CC3(TIMx);
+                unmaskCaptureIT(TIMx);
+            } else {
+                armGapTimeout(TIMx, LL_TIM_GetCounter(TIMx));
+            }
+        }
+        return;
+    }
+    if ((LL_TIM_IsActiveFlag_CC1(TIMx) || LL_TIM_IsActiveFlag_CC2(TIMx)) && stormDetected(params)) {
+        maskCaptureIT(TIMx);
+        armGapTimeout(TIMx, LL_TIM_GetCounter(TIMx));
+        return;
+    }
+#endif
+
+    if (LL_TIM_IsActiveFlag_CC1(TIMx)) {
+        // Falling edge
+        uint16_t ccr = LL_TIM_IC_GetCaptureCH1(TIMx);
+        uint16_t ticks = captureDuration(params, TIMx, ccr);
+        LL_TIM_ClearFlag_CC1(TIMx);
+
+        if (ticks > GAP_TICKS) {
+            // The timeout is pending behind this edge
+            gapDetected(params);
+        }
+
+        if (params->rcvstate == IR_REC_STATE_IDLE) {
+            startFrame(params, ticks);
+            params->rcvstate = IR_REC_STATE_MARK;
+        } else if (params->rcvstate == IR_REC_STATE_STOP) {
+            dropFrameStart(params);
+        } else {
+            storeDuration(params, ticks);
+            params->rcvstate = IR_REC_STATE_MARK;
+        }
+        // A header mark may well be longer than _GAP
+        LL_TIM_DisableIT_CC3(TIMx);
+    }
+    else if (LL_TIM_IsActiveFlag_CC2(TIMx)) {
+        // Rising edge
+        uint16_t ccr = LL_TIM_IC_GetCaptureCH2(TIMx);
+        uint16_t ticks = captureDuration(params, TIMx, ccr);
+        LL_TIM_ClearFlag_CC2(TIMx);
+
+        if (params->rcvstate == IR_REC_STATE_MARK) {
+            storeMark(params, ticks);
+        }
+        armGapTimeout(TIMx, ccr);
+    }
+    else if (LL_TIM_IsActiveFlag_CC3(TIMx)) {
+        LL_TIM_ClearFlag_CC3(TIMx);
+        LL_TIM_DisableIT_CC3(TIMx);
+        gapDetected(params);
+    }
+    else if (LL_TIM_IsActiveFlag_UPDATE(TIMx)) {
+        LL_TIM_ClearFlag_UPDATE(TIMx);
+        params->overflows++;
+    }
+
+#ifdef BLINKLED
+    // If requested, flash LED while receiving IR data
+    if (params->blinkflag) {
+        if (params->rcvstate == IR_REC_STATE_MARK) {
+            BLINKLED_ON();
+        } else {
+            BLINKLED_OFF();
+        }
+    }
+#endif // BLINKLED
+}
+
+#elif defined(USE_TIMER_IC_MODE)
 // Timer Input Capture mode IRQ handler.
 // Fires on Rising edge, Falling edge and Overflow
 //
-static inline void timerInputCaptureHandler(void) {
-    TIM_TypeDef *TIMx = IR_RECEIVE_TIM;
+static inline void timerInputCaptureHandler(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    TIM_TypeDef *TIMx = receiver->hw.tim;
 
-    if (irparams.rawlen >= RAW_BUFFER_LENGTH) {
-        // Flag up a read overflow; Stop the State Machine
-        irparams.overflow = true;
-        irparams.rcvstate = IR_REC_STATE_STOP;
+#ifdef IR_STORM_EDGES
+    if (params->storming) {
+        // Capture interrupts are masked, the overflow polls the end of the backoff every TIM_PERIOD
+        LL_TIM_ClearFlag_UPDATE(TIMx);
+        if (stormOver(params)) {
+            LL_TIM_DisableIT_UPDATE(TIMx);
+            unmaskCaptureIT(TIMx);
+        }
+        return;
     }
+    if ((LL_TIM_IsActiveFlag_CC1(TIMx) || LL_TIM_IsActiveFlag_CC2(TIMx)) && stormDetected(params)) {
+        maskCaptureIT(TIMx);
+        LL_TIM_ClearFlag_UPDATE(TIMx);
+        LL_TIM_EnableIT_UPDATE(TIMx);
+        return;
+    }
+#endif
 
     if (LL_TIM_IsActiveFlag_CC1(TIMx)) {
         // Falling edge
         uint32_t ccr = LL_TIM_IC_GetCaptureCH1(TIMx) / MICROS_PER_TICK;
 
-        if (irparams.rcvstate == IR_REC_STATE_IDLE) {
-            irparams.overflow = false;
-            irparams.rawlen = 0;
-        }
-        if (irparams.rcvstate != IR_REC_STATE_STOP) {
-            irparams.rawbuf[irparams.rawlen++] = ccr;
-            irparams.rcvstate = IR_REC_STATE_MARK;
+        if (params->rcvstate == IR_REC_STATE_IDLE) {
+            startFrame(params, ccr);
+            params->rcvstate = IR_REC_STATE_MARK;
+        } else if (params->rcvstate == IR_REC_STATE_STOP) {
+            dropFrameStart(params);
+        } else {
+            storeDuration(params, ccr);
+            params->rcvstate = IR_REC_STATE_MARK;
         }
         LL_TIM_SetCounter(TIMx, 0);
         LL_TIM_ClearFlag_CC1(TIMx);
@@ -122,19 +716,19 @@ static inline void timerInputCaptureHandler(void) {
     }
     else if (LL_TIM_IsActiveFlag_CC2(TIMx)) {
         // Rising edge
-        if (irparams.rcvstate != IR_REC_STATE_STOP) {
-            irparams.rawbuf[irparams.rawlen++] = LL_TIM_IC_GetCaptureCH2(TIMx) / MICROS_PER_TICK;
-            irparams.rcvstate = IR_REC_STATE_SPACE;
+        if (params->rcvstate == IR_REC_STATE_MARK) {
+            storeMark(params, LL_TIM_IC_GetCaptureCH2(TIMx) / MICROS_PER_TICK);
         }
         LL_TIM_SetCounter(TIMx, 0);
         LL_TIM_ClearFlag_CC2(TIMx);
     }
     else if (LL_TIM_IsActiveFlag_UPDATE(TIMx)) {
-        if (irparams.rcvstate != IR_REC_STATE_IDLE) {
+        if (params->rcvstate == IR_REC_STATE_MARK || params->rcvstate == IR_REC_STATE_SPACE) {
             // A long Space, indicates gap between codes
-            // Flag the current code as ready for processing
-            // Switch to STOP
-            irparams.rcvstate = IR_REC_STATE_STOP;
+            // Hand the current code over for processing
+            commitFrame(params);
+        } else if (params->rcvstate == IR_REC_STATE_STOP) {
+            dropFrameEnd(params);
         }
         LL_TIM_ClearFlag_UPDATE(TIMx);
         LL_TIM_DisableIT_UPDATE(TIMx);
@@ -142,8 +736,8 @@ static inline void timerInputCaptureHandler(void) {
 
 #ifdef BLINKLED
     // If requested, flash LED while receiving IR data
-    if (irparams.blinkflag) {
-        if (irparams.rcvstate == IR_REC_STATE_MARK) {
+    if (params->blinkflag) {
+        if (params->rcvstate == IR_REC_STATE_MARK) {
             BLINKLED_ON();
         } else {
             BLINKLED_OFF();
@@ -158,70 +752,67 @@ static inline void timerInputCaptureHandler(void) {
 // Fires every 50uS.
 // Recorded in ticks of 50uS [microseconds, 0.000050 seconds]
 //
-static inline void timerPeriodicHandler(void) {
-    TIM_TypeDef *TIMx = IR_RECEIVE_TIM;
+static inline void timerPeriodicHandler(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    TIM_TypeDef *TIMx = receiver->hw.tim;
 
     if (LL_TIM_IsActiveFlag_UPDATE(TIMx)) {
         LL_TIM_ClearFlag_UPDATE(TIMx);
         
         // Read if IR Receiver -> SPACE [xmt LED off] or a MARK [xmt LED on]
-        uint8_t irdata = (uint8_t)IR_READPIN;
+        uint8_t irdata = (uint8_t)IR_READPIN(&receiver->hw);
 
-        irparams.timer++;  // One more 50uS tick
-        if (irparams.rawlen >= RAW_BUFFER_LENGTH) {
-            // Flag up a read overflow; Stop the State Machine
-            irparams.overflow = true;
-            irparams.rcvstate = IR_REC_STATE_STOP;
-        }
+        params->timer++;  // One more 50uS tick
 
         /*
         * Due to a ESP32 compiler bug https://github.com/espressif/esp-idf/issues/1552 no switch statements are possible for ESP32
         * So we change the code to if / else if
         */
-    //    switch (irparams.rcvstate) {
+    //    switch (params->rcvstate) {
         //......................................................................
-        if (irparams.rcvstate == IR_REC_STATE_IDLE) { // In the middle of a gap
+        if (params->rcvstate == IR_REC_STATE_IDLE) { // In the middle of a gap
             if (irdata == MARK) {\
-                if (irparams.timer < GAP_TICKS) {  // Not big enough to be a gap.
-                    irparams.timer = 0;
+                if (params->timer < GAP_TICKS) {  // Not big enough to be a gap.
+                    params->timer = 0;
                 } else {
                     // Gap just ended; Record gap duration; Start recording transmission
                     // Initialize all state machine variables
-                    irparams.overflow = false;
-                    irparams.rawlen = 0;
-                    irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-                    irparams.timer = 0;
-                    irparams.rcvstate = IR_REC_STATE_MARK;
+                    startFrame(params, params->timer);
+                    params->timer = 0;
+                    params->rcvstate = IR_REC_STATE_MARK;
                 }
             }
-        } else if (irparams.rcvstate == IR_REC_STATE_MARK) {  // Timing Mark
+        } else if (params->rcvstate == IR_REC_STATE_MARK) {  // Timing Mark
             if (irdata == SPACE) {   // Mark ended; Record time
-                irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-                irparams.timer = 0;
-                irparams.rcvstate = IR_REC_STATE_SPACE;
+                storeMark(params, params->timer);
+                params->timer = 0;
             }
-        } else if (irparams.rcvstate == IR_REC_STATE_SPACE) {  // Timing Space
+        } else if (params->rcvstate == IR_REC_STATE_SPACE) {  // Timing Space
             if (irdata == MARK) {  // Space just ended; Record time
-                irparams.rawbuf[irparams.rawlen++] = irparams.timer;
-                irparams.timer = 0;
-                irparams.rcvstate = IR_REC_STATE_MARK;
+                storeDuration(params, params->timer);
+                params->timer = 0;
+                params->rcvstate = IR_REC_STATE_MARK;
 
-            } else if (irparams.timer > GAP_TICKS) {  // Space
+            } else if (params->timer > GAP_TICKS) {  // Space
                 // A long Space, indicates gap between codes
-                // Flag the current code as ready for processing
-                // Switch to STOP
+                // Hand the current code over for processing
                 // Don't reset timer; keep counting Space width
-                irparams.rcvstate = IR_REC_STATE_STOP;
+                commitFrame(params);
             }
-        } else if (irparams.rcvstate == IR_REC_STATE_STOP) {  // Waiting; Measuring Gap
+        } else if (params->rcvstate == IR_REC_STATE_STOP) {  // Ring full; Measuring Gap
             if (irdata == MARK) {
-                irparams.timer = 0;  // Reset gap timer
+                if (params->timer >= GAP_TICKS) {
+                    dropFrameStart(params);
+                }
+                params->timer = 0;  // Reset gap timer
+            } else if (params->timer > GAP_TICKS) {
+                dropFrameEnd(params);
             }
         }
 
     #ifdef BLINKLED
         // If requested, flash LED while receiving IR data
-        if (irparams.blinkflag) {
+        if (params->blinkflag) {
             if (irdata == MARK) {
                 BLINKLED_ON();   // if no user defined LED pin, turn default LED pin for the hardware on
             } else {
@@ -234,14 +825,31 @@ static inline void timerPeriodicHandler(void) {
 #endif
 
 
-bool IR_TimerIRQHandler(void) {
-#ifdef USE_TIMER_IC_MODE
-    timerInputCaptureHandler();
+//+=============================================================================
+// Timer IRQ handler of a receiver, call it from the IRQ of receiver->hw.tim.
+// Returns true if a frame is waiting for the decoder.
+//
+bool IR_receiverIRQHandler(ir_receiver_t *receiver) {
+    IR_PROFILE_BEGIN(start);
+    uint8_t committed = receiver->params.head;
+
+#if defined(USE_TIMER_DMA_MODE)
+    timerDMAHandler(receiver);
+#elif defined(USE_TIMER_IC_FREE_RUNNING)
+    timerFreeRunningHandler(receiver);
+#elif defined(USE_TIMER_IC_MODE)
+    timerInputCaptureHandler(receiver);
 #else
-    timerPeriodicHandler();
+    timerPeriodicHandler(receiver);
 #endif // USE_TIMER_IC_MODE
-    if (irparams.rcvstate == IR_REC_STATE_STOP) {
-        return true;
+
+    if (receiver->params.head != committed) {
+        notifyFrame(receiver);
     }
-    return false;
-}
\ No newline at end of file
+    IR_PROFILE_END(IR_PROFILE_TIMER_ISR, start);
+    return framesPending(&receiver->params);
+}
+
+bool IR_TimerIRQHandler(void) {
+    return IR_receiverIRQHandler(&IR_defaultReceiver);
+}
@@ -129,6 +129,19 @@ typedef enum {
     WHYNTER,
 } ir_decode_type_t;
 
+/** Number of ir_decode_type_t values from UNUSED on */
+#define IR_DECODE_TYPES (WHYNTER + 1)
+
+/**
+ * Set of protocols IR_decode() tries, see IR_setProtocols().
+ * Bit n is the protocol with ir_decode_type_t n, the hash decoder has a bit of its own.
+ */
+typedef uint32_t ir_protocol_mask_t;
+
+#define IR_PROTOCOL_BIT(type)   ((ir_protocol_mask_t)1 << (type))   ///< Bit of a decoder in an ir_protocol_mask_t
+#define IR_PROTOCOL_HASH        IR_PROTOCOL_BIT(IR_DECODE_TYPES)    ///< Bit of the hash decoder (DECODE_HASH)
+#define IR_PROTOCOLS_ALL        (IR_PROTOCOL_HASH | (IR_PROTOCOL_HASH - 1))
+
 /**
  * Comment this out for lots of lovely debug output.
  */
@@ -158,14 +171,66 @@ typedef enum {
 
 //------------------------------------------------------------------------------
 // Mark & Space matching functions
+// Inline, so the compiler folds TICKS_LOW()/TICKS_HIGH() of a constant duration
+// and a match is two compares without any division. With DEBUG the tracing
+// versions in IRremote.c are called instead.
 //
+#ifdef DEBUG
 int MATCH(unsigned int measured, unsigned int desired);
 int MATCH_MARK(uint16_t measured_ticks, unsigned int desired_us);
 int MATCH_SPACE(uint16_t measured_ticks, unsigned int desired_us);
+#else
+static inline int MATCH(unsigned int measured, unsigned int desired) {
+    return measured >= TICKS_LOW(desired) && measured <= TICKS_HIGH(desired);
+}
+
+// Due to sensor lag, when received, Marks tend to be too long
+static inline int MATCH_MARK(uint16_t measured_ticks, unsigned int desired_us) {
+    return measured_ticks >= TICKS_LOW(desired_us + MARK_EXCESS_MICROS)
+            && measured_ticks <= TICKS_HIGH(desired_us + MARK_EXCESS_MICROS);
+}
+
+// Due to sensor lag, when received, Spaces tend to be too short
+static inline int MATCH_SPACE(uint16_t measured_ticks, unsigned int desired_us) {
+    return measured_ticks >= TICKS_LOW(desired_us - MARK_EXCESS_MICROS)
+            && measured_ticks <= TICKS_HIGH(desired_us - MARK_EXCESS_MICROS);
+}
+#endif
+
+/**
+ * Accepted range of a duration, in MICROS_PER_TICK.
+ * Filled in at compile time by IR_MARK_TICKS() and IR_SPACE_TICKS(), so
+ * matching against it needs neither a call nor a division.
+ */
+typedef struct {
+    uint16_t low;                   ///< Shortest accepted duration
+    uint16_t high;                  ///< Longest accepted duration
+} ir_ticks_t;
+
+/** Range MATCH_MARK(ticks, us) accepts, with a tolerance of tolerance percent */
+#define IR_MARK_TICKS_TOL(us, tolerance) \
+    { TICKS_LOW_TOL((us) + MARK_EXCESS_MICROS, tolerance), TICKS_HIGH_TOL((us) + MARK_EXCESS_MICROS, tolerance) }
+/** Range MATCH_SPACE(ticks, us) accepts, with a tolerance of tolerance percent */
+#define IR_SPACE_TICKS_TOL(us, tolerance) \
+    { TICKS_LOW_TOL((us) - MARK_EXCESS_MICROS, tolerance), TICKS_HIGH_TOL((us) - MARK_EXCESS_MICROS, tolerance) }
+#define IR_MARK_TICKS(us)   IR_MARK_TICKS_TOL(us, TOLERANCE)    ///< Range MATCH_MARK(ticks, us) accepts
+#define IR_SPACE_TICKS(us)  IR_SPACE_TICKS_TOL(us, TOLERANCE)   ///< Range MATCH_SPACE(ticks, us) accepts
+#define IR_NO_TICKS         { 0, 0 }                            ///< Duration the protocol does not have
+
+static inline bool IR_matchTicks(uint16_t ticks, const ir_ticks_t *range) {
+    return ticks >= range->low && ticks <= range->high;
+}
 
 /****************************************************
  *                     RECEIVING
  ****************************************************/
+/**
+ * State the decoders keep between the frames of a receiver.
+ */
+typedef struct {
+    bool sharpAltRepeatSkipped; ///< Sharp Alt: the repeat following the inverted frame was ignored
+} ir_decoder_state_t;
+
 /**
  * Results returned from the decoder
  */
@@ -176,13 +241,32 @@ typedef struct {
     uint16_t bits;              ///< Number of bits in decoded value
     uint16_t magnitude;         ///< Used by MagiQuest [16-bits]
     bool isRepeat;              ///< True if repeat of value is detected
+#if DECODE_HASH
+    uint16_t action;            ///< Learned action of an UNKNOWN value, see IR_setLearnedCodes() and IR_setTemplates(), else IR_LEARNED_NONE
+#endif
 
     // next 3 values are copies of irparams values - see IRremoteint.h
-    uint16_t *rawbuf;           ///< Raw intervals in 50uS ticks
+    irraw_t *rawbuf;            ///< Raw intervals in MICROS_PER_TICK units (1us in input capture mode, 50us in periodic mode), read with IR_RAW()
+#ifdef USE_IR_COMPACT_RAWBUF
+    uint16_t *rawlong;          ///< Long durations referred to by compact rawbuf entries
+#endif
     uint16_t rawlen;            ///< Number of records in rawbuf
     bool overflow;              ///< true if IR raw code too long
+#ifdef USE_IR_LONG_FRAMES
+    uint8_t *data;              ///< Bits of a long frame, see IR_setLongFrames(), bits tells how many. NULL for other frames
+#endif
+    ir_decoder_state_t *state;  ///< Decoder state of the receiver the frame came from, NULL if there is none
 } ir_decode_results;
 
+/**
+ * Duration of raw entry index in MICROS_PER_TICK units, independent of the capture format.
+ */
+#ifdef USE_IR_COMPACT_RAWBUF
+#define IR_RAW(results, index)  IR_rawValue((results)->rawbuf, (results)->rawlong, (index))
+#else
+#define IR_RAW(results, index)  ((results)->rawbuf[index])
+#endif
+
 /**
  * DEPRECATED
  * Decoded value for NEC and others when a repeat code is received
@@ -203,6 +287,14 @@ bool IR_decode(ir_decode_results *results);
  */
 void IR_enableIRIn(void);
 
+/**
+ * Generate the dispatch table of IR_decode() from the decoder signatures.
+ * Called by IR_enableIRIn() and IR_receiverEnable(). Boards supplying their own
+ * enable call it once before enabling the receive interrupt, otherwise the first
+ * IR_decode() generates it and USE_IR_EARLY_FRAME_END waits for the gap until then.
+ */
+void IR_decodeInit(void);
+
 /**
  * Disable IR reception.
  */
@@ -226,10 +318,70 @@ bool IR_isIdle(void);
 bool IR_available(ir_decode_results *results);
 
 /**
- * Called to re-enable IR reception.
+ * Returns true if a received frame waits for IR_decode() / IR_available().
+ * IR_decode() also returns false for a frame it throws away, a task that blocks
+ * on the frame signal drains the ring until this is false before it waits again.
+ */
+bool IR_framePending(void);
+
+/**
+ * Called to release the frame returned by IR_decode() / IR_available()
+ * and to re-enable IR reception if the frame ring was full.
  */
 void IR_resume(void);
 
+/**
+ * Returns the number of frames dropped because the frame ring was full
+ * or, with USE_IR_EDGE_FIFO, because they lost entries to a FIFO overrun.
+ * See IR_FRAME_RING_LENGTH and IR_EDGE_FIFO_LENGTH.
+ */
+uint32_t IR_getDroppedFrames(void);
+
+/**
+ * Health counters of a receiver, all counting since IR_enableIRIn().
+ * Congestion shows up as dropped frames or overruns while the decoders keep up,
+ * decoder tuning problems as unknown frames or hash fallbacks.
+ */
+typedef struct {
+    uint32_t frames;                    ///< Frames captured by the ISR
+    uint32_t edges;                     ///< Entries of the captured frames, including the gaps
+    uint32_t dropped;                   ///< Frames dropped by the ISR because the frame ring was full
+    uint32_t storms;                    ///< Interrupt storms, see IR_STORM_EDGES
+    uint32_t overruns;                  ///< Frames lost to an edge FIFO overrun (USE_IR_EDGE_FIFO)
+    uint32_t overflows;                 ///< Frames longer than RAW_BUFFER_LENGTH, or clipped (USE_IR_COMPACT_RAWBUF)
+    uint32_t unknown;                   ///< Frames no decoder matched
+    uint32_t hashed;                    ///< Frames only the hash decoder (DECODE_HASH) matched
+    uint32_t cached;                    ///< Frames answered by the repeat cache (IR_REPEAT_CACHE_MS), also counted in decoded
+    uint32_t decoded[IR_DECODE_TYPES];  ///< Frames decoded, indexed by ir_decode_type_t
+} ir_receiver_stats_t;
+
+/**
+ * Get a consistent copy of the health counters without stopping reception.
+ */
+void IR_getStats(ir_receiver_stats_t *stats);
+
+#ifdef IR_STORM_EDGES
+/**
+ * Returns how often the capture interrupts were masked because of an interrupt storm.
+ * See IR_STORM_EDGES.
+ */
+uint32_t IR_getStorms(void);
+#endif
+
+/**
+ * Select the protocols IR_decode() tries, e.g. from the site configuration at boot.
+ * Decoders outside the mask are skipped without being called. Protocols compiled
+ * out with DECODE_* stay off whatever the mask says. All are on by default.
+ * Call it from the task which calls IR_decode().
+ * @param protocols IR_PROTOCOL_BIT() of each protocol to decode, IR_PROTOCOL_HASH for the hash decoder.
+ */
+void IR_setProtocols(ir_protocol_mask_t protocols);
+
+/**
+ * Returns the protocols IR_decode() tries, see IR_setProtocols().
+ */
+ir_protocol_mask_t IR_getProtocols(void);
+
 const char* IR_getProtocolString(ir_decode_results *results);
 void IR_printResultShort(ir_decode_results *results);
 void IR_printIRResultRaw(ir_decode_results *results);
@@ -249,6 +401,84 @@ void IR_printIRResultAsPronto(ir_decode_results *results, unsigned int frequency
 bool IR_decodePulseDistanceData(ir_decode_results *results, uint8_t aNumberOfBits, uint8_t aStartOffset, unsigned int aBitMarkMicros,
         unsigned int aOneSpaceMicros, unsigned int aZeroSpaceMicros, bool aMSBfirst);
 
+/**
+ * Timing description of a pulse distance protocol.
+ * Each protocol file exports one, IR_decodeProtocol() and the streaming decoder work on them.
+ */
+typedef struct {
+    ir_decode_type_t decode_type;   ///< Protocol reported on success
+    ir_ticks_t headerMark;          ///< Header mark, IR_NO_TICKS if the protocol has no header
+    ir_ticks_t headerSpace;         ///< Header space
+    ir_ticks_t repeatSpace;         ///< Space after the header mark of a repeat frame, IR_NO_TICKS if there is none
+    ir_ticks_t bitMark;             ///< Mark of every bit
+    ir_ticks_t oneSpace;            ///< Space of a 1 bit
+    ir_ticks_t zeroSpace;           ///< Space of a 0 bit
+    uint8_t bits;                   ///< Number of bits, including the address bits
+    uint8_t addressBits;            ///< The first addressBits go to address, the rest to value
+    uint8_t flags;                  ///< IR_PROTOCOL_* flags
+} ir_protocol_t;
+
+#define IR_PROTOCOL_MSB_FIRST   0x01    ///< Data is sent MSB first
+#define IR_PROTOCOL_STOP_BIT    0x02    ///< Data is followed by a stop mark of bitMark
+#define IR_PROTOCOL_LEAD_IN     0x04    ///< A bit mark and a zero space precede the header
+#define IR_PROTOCOL_EXACT_LENGTH 0x08   ///< rawlen must be exactly IR_protocolLength(), not at least
+#define IR_PROTOCOL_HEADERLESS_REPEAT 0x10 ///< A frame without header is a repeat, its data is not checked
+#define IR_PROTOCOL_INVERTED_COMMAND 0x20  ///< Data is a command byte and its complement, value is the command
+
+/**
+ * Number of durations of a complete frame of protocol, including the gap.
+ */
+static inline uint16_t IR_protocolLength(const ir_protocol_t *protocol) {
+    uint16_t length = 1 + 2 * protocol->bits;
+    if (protocol->headerMark.high) {
+        length += 2;
+    }
+    if (protocol->flags & IR_PROTOCOL_LEAD_IN) {
+        length += 2;
+    }
+    if (protocol->flags & IR_PROTOCOL_STOP_BIT) {
+        length++;
+    }
+    return length;
+}
+
+/**
+ * Decode a frame of the pulse distance protocol described by protocol.
+ * Sets value, address, bits and decode_type like the hand written decoders.
+ */
+bool IR_decodeProtocol(ir_decode_results *results, const ir_protocol_t *protocol);
+
+/**
+ * Frames a decoder can accept, by their first mark and rawlen.
+ * A signature must never exclude a frame the decoder would accept.
+ */
+typedef struct {
+    uint16_t markLow;               ///< Shortest first mark, in MICROS_PER_TICK
+    uint16_t markHigh;              ///< Longest first mark, in MICROS_PER_TICK
+    uint16_t minLength;             ///< Shortest rawlen
+    uint16_t maxLength;             ///< Longest rawlen
+} ir_signature_t;
+
+/** First mark matching MATCH_MARK(mark, markMicros), rawlen from minLength to maxLength */
+#define IR_SIGNATURE(markMicros, minLength, maxLength) \
+    { TICKS_LOW((markMicros) + MARK_EXCESS_MICROS), TICKS_HIGH((markMicros) + MARK_EXCESS_MICROS), (minLength), (maxLength) }
+/** Any first mark, for decoders which do not check it */
+#define IR_SIGNATURE_ANY_MARK(minLength, maxLength) { 0, 0xFFFF, (minLength), (maxLength) }
+/** Unused signature slot */
+#define IR_SIGNATURE_NONE   { 0, 0, 1, 0 }
+/** No upper limit of rawlen */
+#define IR_ANY_LENGTH       0xFFFF
+
+/**
+ * A decoder of IR_decode() with the signatures of the frames it can accept,
+ * so the dispatch only calls decoders which may match.
+ */
+typedef struct {
+    bool (*decode)(ir_decode_results *results);
+    ir_decode_type_t decode_type;   ///< Protocol of the decoder, UNKNOWN for the hash decoder
+    ir_signature_t signatures[2];   ///< The frame must match one of them
+} ir_decoder_t;
+
 //......................................................................
 #if DECODE_RC5
 /**
@@ -325,6 +555,523 @@ bool IR_decodeBoseWave(ir_decode_results *results);
 bool IR_decodeMagiQuest(ir_decode_results *results);
 #endif
 
+//......................................................................
+#if DECODE_NEC_STANDARD
+extern const ir_decoder_t IR_decoderNECStandard;
+#endif
+#if DECODE_NEC
+extern const ir_decoder_t IR_decoderNEC;
+#endif
+#if DECODE_SHARP
+extern const ir_decoder_t IR_decoderSharp;
+#endif
+#if DECODE_SHARP_ALT
+extern const ir_decoder_t IR_decoderSharpAlt;
+#endif
+#if DECODE_SONY
+extern const ir_decoder_t IR_decoderSony;
+#endif
+#if DECODE_SANYO
+extern const ir_decoder_t IR_decoderSanyo;
+#endif
+#if DECODE_RC5
+extern const ir_decoder_t IR_decoderRC5;
+#endif
+#if DECODE_RC6
+extern const ir_decoder_t IR_decoderRC6;
+#endif
+#if DECODE_PANASONIC
+extern const ir_decoder_t IR_decoderPanasonic;
+#endif
+#if DECODE_LG
+extern const ir_decoder_t IR_decoderLG;
+#endif
+#if DECODE_JVC
+extern const ir_decoder_t IR_decoderJVC;
+#endif
+#if DECODE_SAMSUNG
+extern const ir_decoder_t IR_decoderSAMSUNG;
+#endif
+#if DECODE_WHYNTER
+extern const ir_decoder_t IR_decoderWhynter;
+#endif
+#if DECODE_DENON
+extern const ir_decoder_t IR_decoderDenon;
+#endif
+#if DECODE_LEGO_PF
+extern const ir_decoder_t IR_decoderLegoPowerFunctions;
+#endif
+#if DECODE_MAGIQUEST
+extern const ir_decoder_t IR_decoderMagiQuest;
+#endif
+
+//......................................................................
+#if DECODE_NEC
+extern const ir_protocol_t IR_protocolNEC;
+#endif
+#if DECODE_NEC_STANDARD
+extern const ir_protocol_t IR_protocolNECStandard;
+#endif
+#if DECODE_JVC
+extern const ir_protocol_t IR_protocolJVC;
+#endif
+#if DECODE_LG
+extern const ir_protocol_t IR_protocolLG;
+#endif
+#if DECODE_SAMSUNG
+extern const ir_protocol_t IR_protocolSAMSUNG;
+#endif
+#if DECODE_DENON
+extern const ir_protocol_t IR_protocolDenon;
+#endif
+#if DECODE_PANASONIC
+extern const ir_protocol_t IR_protocolPanasonic;
+#endif
+#if DECODE_WHYNTER
+extern const ir_protocol_t IR_protocolWhynter;
+#endif
+
+/****************************************************
+ *                STREAMING DECODE
+ ****************************************************/
+/**
+ * Number of protocols the streaming decoder can follow.
+ */
+#define IR_STREAM_PROTOCOLS (DECODE_NEC + DECODE_JVC + DECODE_LG + DECODE_SAMSUNG + DECODE_DENON + DECODE_PANASONIC)
+
+/**
+ * Protocols the streaming decoder follows, as an ir_protocol_mask_t.
+ */
+#define IR_STREAM_PROTOCOL_MASK ((DECODE_NEC ? IR_PROTOCOL_BIT(NEC) : 0) | (DECODE_JVC ? IR_PROTOCOL_BIT(JVC) : 0) \
+        | (DECODE_LG ? IR_PROTOCOL_BIT(LG) : 0) | (DECODE_SAMSUNG ? IR_PROTOCOL_BIT(SAMSUNG) : 0) \
+        | (DECODE_DENON ? IR_PROTOCOL_BIT(DENON) : 0) | (DECODE_PANASONIC ? IR_PROTOCOL_BIT(PANASONIC) : 0))
+
+#if defined(USE_IR_EARLY_FRAME_END) && IR_STREAM_PROTOCOLS == 0
+#error "USE_IR_EARLY_FRAME_END requires at least one of the pulse distance decoders"
+#endif
+
+#if IR_STREAM_PROTOCOLS > 0
+/**
+ * State of the streaming decoder.
+ * Every protocol is a candidate which is advanced by each duration and
+ * dropped as soon as a duration does not fit. Only live candidates do work per edge.
+ */
+typedef struct {
+    uint16_t index;                         ///< Number of durations fed, including the gap
+    uint16_t live;                          ///< Candidates not yet ruled out, bit n is candidate n
+    uint16_t repeat;                        ///< Candidates which see a repeat frame
+    uint16_t disabled;                      ///< Candidates IR_streamReset() leaves out, see IR_streamSetProtocols()
+    uint32_t data[IR_STREAM_PROTOCOLS];     ///< Bits collected per candidate
+    uint16_t address[IR_STREAM_PROTOCOLS];  ///< Address bits collected per candidate
+} ir_stream_decoder;
+
+/**
+ * Prepare the decoder for a new frame.
+ */
+void IR_streamReset(ir_stream_decoder *decoder);
+
+/**
+ * Leave the protocols outside of protocols out from the next frame on.
+ */
+void IR_streamSetProtocols(ir_stream_decoder *decoder, ir_protocol_mask_t protocols);
+
+/**
+ * Feed the next duration of the frame, the first one is the gap.
+ * @param ticks Duration in MICROS_PER_TICK.
+ * @return false if no candidate is left, the rest of the frame can be skipped.
+ */
+bool IR_streamFeed(ir_stream_decoder *decoder, uint16_t ticks);
+
+/**
+ * Get the result after the last duration of the frame was fed.
+ * @return true if a candidate matched the frame completely.
+ */
+bool IR_streamResult(ir_stream_decoder *decoder, ir_decode_results *results);
+
+/**
+ * Candidates of the protocols outside of protocols, as a bit set like ir_stream_decoder::disabled.
+ */
+uint16_t IR_streamDisabled(ir_protocol_mask_t protocols);
+
+#ifdef USE_IR_EARLY_FRAME_END
+/**
+ * Follow the current frame with the end of frame predictor, called by the ISR for every entry.
+ * @param index Number of the entry in the frame, 0 is the gap.
+ * @param ticks Duration in MICROS_PER_TICK.
+ */
+void IR_streamTrack(struct irframeend_struct *tracker, uint16_t index, uint16_t ticks);
+
+/**
+ * Predict the end of a frame before the gap, called by the ISR after each mark.
+ * @param tracked Number of entries fed to IR_streamTrack(), including the gap.
+ * @param length Number of entries received so far, including the gap and a mark the glitch filter still holds.
+ * @param lastMark The mark just received in MICROS_PER_TICK.
+ * @return true if a candidate matched the complete frame and no enabled decoder could take a longer one.
+ */
+bool IR_streamFrameComplete(const struct irframeend_struct *tracker, uint16_t tracked, uint16_t length, uint16_t lastMark);
+
+/**
+ * Check the decoders the streaming decoder does not cover for a longer frame starting with firstMark.
+ * @param disabledProtocols Protocols to leave out.
+ * @param length Number of entries received so far, including the gap.
+ * @return true if an enabled decoder has a signature accepting firstMark with more than length entries.
+ */
+bool IR_frameMayGrow(ir_protocol_mask_t disabledProtocols, uint16_t firstMark, uint16_t length);
+#endif
+#endif
+
+#ifdef USE_IR_LONG_FRAMES
+/**
+ * State of the long frame decoder (USE_IR_LONG_FRAMES).
+ * Follows one pulse distance protocol with frames of any length, e.g. the 100 to 300 bit state
+ * frames of air conditioners. Every space is turned into a bit and packed into buffer right away,
+ * so neither rawbuf nor value limit the length of the frame.
+ */
+typedef struct irlongframe_struct {
+    const ir_protocol_t *protocol;  ///< Timings, needs IR_PROTOCOL_STOP_BIT, bits is the shortest frame accepted. NULL if off
+    uint8_t *buffer;                ///< Bits in the order received, the first one in the MSB (IR_PROTOCOL_MSB_FIRST) or LSB of buffer[0]
+    uint16_t size;                  ///< Size of buffer in bytes, longer frames are rejected
+    uint16_t index;                 ///< Number of durations fed, including the gap
+    uint16_t bits;                  ///< Bits packed so far
+    bool live;                      ///< Every duration so far fits protocol
+} ir_long_frame_decoder;
+
+/**
+ * Prepare the decoder for a new frame.
+ */
+void IR_longFrameReset(ir_long_frame_decoder *decoder);
+
+/**
+ * Feed the next duration of the frame, the first one is the gap.
+ * @param ticks Duration in MICROS_PER_TICK.
+ * @return false if the frame does not fit the protocol.
+ */
+bool IR_longFrameFeed(ir_long_frame_decoder *decoder, uint16_t ticks);
+
+/**
+ * Check the frame after its last duration was fed.
+ * @return true if the frame is complete, i.e. at least protocol->bits bits followed by the stop mark.
+ */
+bool IR_longFrameComplete(const ir_long_frame_decoder *decoder);
+
+/**
+ * Get the result after the last duration of the frame was fed.
+ * Sets decode_type, bits and data of results, value and address are 0.
+ * @return true if the frame is complete, i.e. at least protocol->bits bits followed by the stop mark.
+ */
+bool IR_longFrameResult(ir_long_frame_decoder *decoder, ir_decode_results *results);
+
+/**
+ * Decode the frames of a pulse distance protocol of any length into buffer (USE_IR_LONG_FRAMES),
+ * e.g. the state frames of an air conditioner. The ISR decodes them as the edges come in,
+ * IR_decode() returns them with results->data pointing to buffer, valid until IR_resume().
+ * Until then the ISR leaves buffer alone, a long frame arriving meanwhile is only received raw.
+ * Takes effect with the next frame, a long frame not yet returned by IR_decode() is dropped.
+ * @param protocol Timings of the frames, see ir_long_frame_decoder. NULL to switch off.
+ * @param buffer Receives the bits.
+ * @param size Size of buffer in bytes, e.g. 38 for up to 304 bits.
+ */
+void IR_setLongFrames(const ir_protocol_t *protocol, uint8_t *buffer, uint16_t size);
+#endif
+
+#if DECODE_HASH
+/****************************************************
+ *                  LEARNED CODES
+ ****************************************************/
+/**
+ * Open addressing table from the values of the hash decoder to application actions,
+ * e.g. the codes learned from an unknown remote. Two parallel arrays of slots, 6 bytes each,
+ * so a table built offline can be const and stay in flash. Build it with IR_learnedInsert(),
+ * on the device into RAM or on the host into the initializers of a const table.
+ * The number of slots is a power of two, keep at least a quarter of them empty so
+ * lookups stay O(1).
+ */
+typedef struct {
+    const uint32_t *hashes;         ///< Hash of each slot, IR_LEARNED_EMPTY if unused
+    const uint16_t *actions;        ///< Action of each slot
+    uint16_t slots;                 ///< Number of slots, a power of two
+} ir_learned_table_t;
+
+#define IR_LEARNED_EMPTY    0       ///< Hash of an unused slot, a code hashing to it cannot be learned
+#define IR_LEARNED_NONE     0xFFFF  ///< ir_decode_results.action if there is no learned action
+
+/**
+ * Add a code to the slots of a table, or change its action if it is there already.
+ * @return false if the table is full, the slot count is no power of two or hash is IR_LEARNED_EMPTY.
+ */
+bool IR_learnedInsert(uint32_t *hashes, uint16_t *actions, uint16_t slots, uint32_t hash, uint16_t action);
+
+/**
+ * Find the action of a hash.
+ * @return true if hash is in the table, its action is stored to action then.
+ */
+bool IR_learnedLookup(const ir_learned_table_t *table, uint32_t hash, uint16_t *action);
+
+/**
+ * Look up every frame only the hash decoder matched in table, IR_decode() stores the
+ * result to ir_decode_results.action. Call it from the task which calls IR_decode().
+ * @param table Learned codes, NULL to switch off.
+ */
+void IR_setLearnedCodes(const ir_learned_table_t *table);
+
+/**
+ * Raw capture of a learned code, for remotes whose hash is not stable.
+ */
+typedef struct {
+    const uint16_t *durations;      ///< Marks and spaces after the gap in MICROS_PER_TICK, see IR_templateCapture()
+    uint16_t length;                ///< Number of durations, rawlen - 1 of the capture
+    uint16_t action;                ///< Action of the code
+} ir_template_t;
+
+#if ! defined(IR_TEMPLATE_BUCKETS)
+#define IR_TEMPLATE_BUCKETS 16      ///< Buckets of the length index of an ir_template_set_t, a power of two
+#endif
+
+#if IR_TEMPLATE_BUCKETS < 1 || (IR_TEMPLATE_BUCKETS & (IR_TEMPLATE_BUCKETS - 1)) || IR_TEMPLATE_BUCKETS > 128
+#error "IR_TEMPLATE_BUCKETS must be a power of two not greater than 128"
+#endif
+
+/**
+ * Templates a frame is matched against when its hash is not in the learned codes.
+ * Only templates of the same length are compared, the length index finds them without
+ * scanning the others. A template qualifies if the durations of the frame lie outside
+ * TOLERANCE of its durations by no more than maxExcess ticks in sum, the qualifying
+ * template with the smallest sum of all deviations wins.
+ */
+typedef struct {
+    const ir_template_t *templates; ///< The templates, in any order
+    uint16_t count;                 ///< Number of templates
+    uint16_t maxExcess;             ///< Sum of the deviations beyond TOLERANCE accepted, in MICROS_PER_TICK
+    uint16_t *order;                ///< count entries of RAM, template numbers by bucket, see IR_templateIndex()
+    uint16_t first[IR_TEMPLATE_BUCKETS + 1]; ///< Bucket b is order[first[b]] to order[first[b + 1] - 1]
+} ir_template_set_t;
+
+/**
+ * Copy the durations of a frame to a template.
+ * @return Number of durations stored, 0 if they do not fit into size entries.
+ */
+uint16_t IR_templateCapture(ir_decode_results *results, uint16_t *durations, uint16_t size);
+
+/**
+ * Build the length index of set, again after templates were added or changed.
+ */
+void IR_templateIndex(ir_template_set_t *set);
+
+/**
+ * Find the template closest to a frame.
+ * @return true if a template qualifies, the action of the closest one is stored to action then.
+ */
+bool IR_templateMatch(const ir_template_set_t *set, ir_decode_results *results, uint16_t *action);
+
+/**
+ * Match every frame only the hash decoder matched, and whose hash is not a learned code,
+ * against set. IR_decode() stores the result to ir_decode_results.action.
+ * Call it from the task which calls IR_decode().
+ * @param set Indexed templates, NULL to switch off.
+ */
+void IR_setTemplates(const ir_template_set_t *set);
+#endif
+
+/****************************************************
+ *                 MULTIPLE RECEIVERS
+ ****************************************************/
+/**
+ * One IR receiver: the hardware it is wired to and all of its reception state.
+ * Receivers do not share any state, each one is driven by the IRQ of its own timer.
+ * The IR_* receive functions without receiver argument work on IR_defaultReceiver.
+ *
+ * Example for a second receiver:
+ *   ir_receiver_t zone2 = { .hw = { TIM21, TIM21_IRQn, GPIOB, LL_GPIO_PIN_14, LL_GPIO_AF_6 } };
+ *   void TIM21_IRQHandler(void) { IR_receiverIRQHandler(&zone2); }
+ */
+typedef struct ir_receiver ir_receiver_t;
+
+/**
+ * Called from the receive ISR when a frame has been committed.
+ * Keep it short, e.g. release a semaphore the decode task waits on.
+ */
+typedef void (*ir_frame_callback_t)(ir_receiver_t *receiver);
+
+/**
+ * Counters of the decoder side, written by the task calling IR_decode().
+ * Guarded by a sequence like the ISR counters, so another task can read them.
+ */
+struct irdecodestats_struct {
+    volatile uint32_t sequence;         ///< Odd while an update is in progress
+    uint32_t overruns;                  ///< Frames lost to an edge FIFO overrun
+    uint32_t overflows;                 ///< Frames longer than RAW_BUFFER_LENGTH, or clipped (USE_IR_COMPACT_RAWBUF)
+    uint32_t unknown;                   ///< Frames no decoder matched
+    uint32_t hashed;                    ///< Frames only the hash decoder matched
+    uint32_t cached;                    ///< Frames answered by the repeat cache
+    uint32_t decoded[IR_DECODE_TYPES];  ///< Frames decoded per ir_decode_type_t
+};
+
+/**
+ * Last fully decoded frame of a receiver and its result, see IR_REPEAT_CACHE_MS.
+ */
+struct irrepeatcache_struct {
+    uint16_t rawlen;                    ///< Length of the frame, 0 if the cache is empty
+    uint16_t durations[RAW_BUFFER_LENGTH]; ///< Durations of the frame, as read by IR_RAW(), without the gap
+    uint32_t time;                      ///< millis() when the frame or its last repeat was decoded
+    ir_decode_type_t decode_type;       ///< Cached result
+    uint16_t address;
+    uint32_t value;
+    uint16_t bits;
+    uint16_t magnitude;
+};
+
+struct ir_receiver {
+    ir_receiver_hw_t hw;                ///< Timer, IRQ and input pin, see IRremoteBoardDefs.h
+    struct irparams_struct params;      ///< State shared with the ISR
+    ir_frame_callback_t frameCallback;  ///< Called from the ISR for every committed frame, may be NULL
+    osThreadId notifyThread;            ///< Thread signalled from the ISR for every committed frame, may be NULL
+    int32_t notifySignals;              ///< Signal flags set on notifyThread
+    struct irdecodestats_struct stats;  ///< Decoder health counters, see IR_receiverGetStats()
+    ir_protocol_mask_t disabledProtocols; ///< Protocols IR_decode() skips, none when zero initialized
+    ir_decoder_state_t decoderState;    ///< Kept between frames, see ir_decode_results::state
+#if DECODE_HASH
+    const ir_learned_table_t *learnedCodes; ///< Looked up for hashed frames, may be NULL
+    const ir_template_set_t *templates; ///< Matched against hashed frames which are no learned code, may be NULL
+#endif
+#ifdef IR_REPEAT_CACHE_MS
+    struct irrepeatcache_struct repeatCache; ///< Result of the last frame for a held key
+#endif
+#ifdef USE_IR_EDGE_FIFO
+    struct irframe_struct edgeFrame;    ///< Assembled from the edge FIFO, never touched by the ISR
+    bool edgeFrameReady;                ///< edgeFrame is complete and not yet released
+    uint16_t edgeOverruns;              ///< FIFO overruns already counted in stats.overruns
+#if defined(USE_IR_STREAM_DECODE) && IR_STREAM_PROTOCOLS > 0
+    ir_stream_decoder edgeStream;       ///< Fed with every duration of edgeFrame
+    bool edgeStreamLive;                ///< edgeStream still has candidates
+#endif
+#ifdef USE_IR_LONG_FRAMES
+    ir_long_frame_decoder longFrame;    ///< Fed by the ISR, see IR_setLongFrames()
+    bool edgeFrameLong;                 ///< edgeFrame was taken by longFrame, its durations may be incomplete
+#endif
+#endif
+};
+
+/**
+ * Receiver used by IR_enableIRIn(), IR_decode() and the other receive functions,
+ * wired as set up by the IRRECEIVE_* and IR_RECEIVE_* defines.
+ */
+extern ir_receiver_t IR_defaultReceiver;
+
+/**
+ * Same as IR_enableIRIn(), IR_disableIRIn(), IR_decode(), IR_available(), IR_framePending(),
+ * IR_resume(), IR_isIdle() and IR_getDroppedFrames(), for the given receiver.
+ */
+void IR_receiverEnable(ir_receiver_t *receiver);
+void IR_receiverDisable(ir_receiver_t *receiver);
+bool IR_receiverDecode(ir_receiver_t *receiver, ir_decode_results *results);
+bool IR_receiverAvailable(ir_receiver_t *receiver, ir_decode_results *results);
+bool IR_receiverFramePending(ir_receiver_t *receiver);
+void IR_receiverResume(ir_receiver_t *receiver);
+bool IR_receiverIsIdle(ir_receiver_t *receiver);
+uint32_t IR_receiverDroppedFrames(ir_receiver_t *receiver);
+#ifdef IR_STORM_EDGES
+uint32_t IR_receiverStorms(ir_receiver_t *receiver);
+#endif
+void IR_receiverGetStats(ir_receiver_t *receiver, ir_receiver_stats_t *stats);
+void IR_receiverSetProtocols(ir_receiver_t *receiver, ir_protocol_mask_t protocols);
+ir_protocol_mask_t IR_receiverGetProtocols(ir_receiver_t *receiver);
+void IR_receiverSetFrameCallback(ir_receiver_t *receiver, ir_frame_callback_t callback);
+void IR_receiverSetFrameSignal(ir_receiver_t *receiver, osThreadId thread, int32_t signals);
+#if DECODE_HASH
+void IR_receiverSetLearnedCodes(ir_receiver_t *receiver, const ir_learned_table_t *table);
+void IR_receiverSetTemplates(ir_receiver_t *receiver, const ir_template_set_t *set);
+#endif
+#ifdef USE_IR_LONG_FRAMES
+void IR_receiverSetLongFrames(ir_receiver_t *receiver, const ir_protocol_t *protocol, uint8_t *buffer, uint16_t size);
+#endif
+
+/**
+ * Call callback from the receive ISR whenever a frame is ready for IR_decode().
+ * @param callback Function to call, NULL to disable.
+ */
+void IR_setFrameCallback(ir_frame_callback_t callback);
+
+/**
+ * Set signals on thread from the receive ISR whenever a frame is ready for IR_decode(),
+ * so a decode task can block in osSignalWait() instead of polling.
+ * @param thread Thread to signal, NULL to disable.
+ * @param signals Signal flags to set.
+ */
+void IR_setFrameSignal(osThreadId thread, int32_t signals);
+
+/**
+ * Timer IRQ handler of a receiver, call it from the interrupt of receiver->hw.tim.
+ * @return true if a frame is waiting for the decoder.
+ */
+bool IR_receiverIRQHandler(ir_receiver_t *receiver);
+
+#ifdef USE_TIMER_DMA_MODE
+/**
+ * DMA IRQ handler of a receiver, call it from the interrupt of receiver->hw.dmaChannel.
+ * Must run at the same interrupt priority as the timer IRQ handler.
+ * @return true if a frame is waiting for the decoder.
+ */
+bool IR_receiverDMAIRQHandler(ir_receiver_t *receiver);
+#endif
+
+/****************************************************
+ *                     PROFILING
+ ****************************************************/
+/**
+ * Measuring points. The decoders are at IR_PROFILE_DECODER + their ir_decode_type_t,
+ * e.g. IR_PROFILE_DECODER + NEC, the hash decoder has a point of its own.
+ */
+typedef enum {
+    IR_PROFILE_TIMER_ISR,       ///< IR_receiverIRQHandler()
+    IR_PROFILE_DMA_ISR,         ///< IR_receiverDMAIRQHandler()
+    IR_PROFILE_STREAM_RESULT,   ///< IR_streamResult() in IR_decode()
+    IR_PROFILE_HASH,            ///< IR_decodeHash()
+    IR_PROFILE_DECODER,         ///< First decoder point
+    IR_PROFILE_POINTS = IR_PROFILE_DECODER + IR_DECODE_TYPES
+} ir_profile_point_t;
+
+#ifdef USE_IR_PROFILE
+/**
+ * Number of histogram buckets. Bucket n counts the runs of 2^n to 2^(n+1)-1 cycles,
+ * bucket 0 also counts 0 cycles and the last bucket everything above.
+ */
+#define IR_PROFILE_BUCKETS  20
+
+/**
+ * Cycles of one measuring point.
+ */
+typedef struct {
+    uint32_t count;                             ///< Number of runs
+    uint32_t min;                               ///< Fastest run
+    uint32_t max;                               ///< Slowest run, the worst case budget
+    uint64_t sum;                               ///< Sum of all runs, the mean is sum / count
+    uint16_t histogram[IR_PROFILE_BUCKETS];     ///< log2 histogram, saturates at 0xFFFF
+} ir_profile_t;
+
+/**
+ * Enable the cycle counter and clear all measuring points.
+ * Called by IR_enableIRIn(), call it once before IR_receiverEnable() if only that is used.
+ */
+void IR_profileReset(void);
+
+/**
+ * Add one run to a measuring point.
+ */
+void IR_profileRecord(ir_profile_point_t point, uint32_t cycles);
+
+/**
+ * Get a consistent copy of a measuring point.
+ * @return false if the point has no runs yet.
+ */
+bool IR_profileGet(ir_profile_point_t point, ir_profile_t *profile);
+
+#define IR_PROFILE_BEGIN(start)         uint32_t start = IR_CYCLE_COUNT()
+#define IR_PROFILE_END(point, start)    IR_profileRecord(point, IR_CYCLES_SINCE(start))
+#else
+#define IR_PROFILE_BEGIN(start)
+#define IR_PROFILE_END(point, start)
+#endif // USE_IR_PROFILE
+
 /****************************************************
  *                     SENDING
  ****************************************************/
@@ -3,6 +3,8 @@
 #include "printf.h"
 #include "IRremote.h"
 
+#define IR_FRAME_SIGNAL 0x0001
+
 static ir_decode_results ir_results;
 
 
@@ -10,6 +12,8 @@ void ir_example_task(void const * argument)
 {
   (void)argument;
 
+  // Get woken up by the receive ISR instead of polling
+  IR_setFrameSignal(osThreadGetId(), IR_FRAME_SIGNAL);
   IR_enableIRIn();
 
   while(1) {
@@ -21,13 +25,14 @@ void ir_example_task(void const * argument)
       printf("-----------------\r\n");
       for (uint16_t i = 1; i < results.rawlen; i++) {
         if (i > 1 && (i - 1) % 8 == 0) printf("\r\n");
-        printf(i & 1 ? "+%04u " : "-%04u ", results.rawbuf[i] * MICROS_PER_TICK);
+        printf(i & 1 ? "+%04u " : "-%04u ", IR_RAW(&results, i) * MICROS_PER_TICK);
       }
       printf("\r\n-----------------\r\n");
 #endif
       IR_resume();
-    } else {
-      osDelay(100);
+    } else if (!IR_framePending()) {
+      // Signals of frames already queued are gone, block only once the ring is empty
+      osSignalWait(IR_FRAME_SIGNAL, osWaitForever);
     }
   }
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+/**
+ * @file irLearned.c
+ * @brief Lookup of learned codes by the value of the hash decoder.
+ *
+ * Open addressing with linear probing. The slot of a hash is taken from
+ * both halves of it and the next slots are tried until the hash or an
+ * empty slot turns up, so a lookup touches one or two slots at a sane load.
+ *
+ * Codes whose hash is not stable are matched against raw templates instead,
+ * by a distance which ignores the deviations within TOLERANCE.
+ */
+
+#include "IRremote.h"
+
+#if DECODE_HASH
+
+// First slot of hash, the high half is folded in as the low bits of FNV are weak
+static inline uint16_t homeSlot(uint32_t hash, uint16_t slots) {
+    return (hash ^ (hash >> 16)) & (slots - 1);
+}
+
+bool IR_learnedInsert(uint32_t *hashes, uint16_t *actions, uint16_t slots, uint32_t hash, uint16_t action) {
+    if (hash == IR_LEARNED_EMPTY || slots == 0 || (slots & (slots - 1)) != 0) {
+        return false;
+    }
+
+    uint16_t slot = homeSlot(hash, slots);
+    for (uint16_t probe = 0; probe < slots; probe++, slot = (slot + 1) & (slots - 1)) {
+        if (hashes[slot] == hash || hashes[slot] == IR_LEARNED_EMPTY) {
+            hashes[slot] = hash;
+            actions[slot] = action;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IR_learnedLookup(const ir_learned_table_t *table, uint32_t hash, uint16_t *action) {
+    if (hash == IR_LEARNED_EMPTY) {
+        return false;
+    }
+
+    uint16_t slot = homeSlot(hash, table->slots);
+    for (uint16_t probe = 0; probe < table->slots; probe++, slot = (slot + 1) & (table->slots - 1)) {
+        uint32_t stored = table->hashes[slot];
+        if (stored == hash) {
+            *action = table->actions[slot];
+            return true;
+        }
+        if (stored == IR_LEARNED_EMPTY) {
+            return false;
+        }
+    }
+    return false;
+}
+
+//+=============================================================================
+// Templates.
+// The index groups the template numbers by length modulo IR_TEMPLATE_BUCKETS
+// with a counting sort, a frame only visits the templates of its bucket.
+//
+uint16_t IR_templateCapture(ir_decode_results *results, uint16_t *durations, uint16_t size) {
+    if (results->rawlen < 2 || results->overflow || results->rawlen - 1 > size) {
+        return 0;
+    }
+    for (uint16_t i = 1; i < results->rawlen; i++) {
+        durations[i - 1] = IR_RAW(results, i);
+    }
+    return results->rawlen - 1;
+}
+
+void IR_templateIndex(ir_template_set_t *set) {
+    uint16_t fill[IR_TEMPLATE_BUCKETS];
+
+    memset(set->first, 0, sizeof(set->first));
+    for (uint16_t i = 0; i < set->count; i++) {
+        set->first[(set->templates[i].length & (IR_TEMPLATE_BUCKETS - 1)) + 1]++;
+    }
+    for (uint8_t bucket = 0; bucket < IR_TEMPLATE_BUCKETS; bucket++) {
+        set->first[bucket + 1] += set->first[bucket];
+        fill[bucket] = set->first[bucket];
+    }
+    for (uint16_t i = 0; i < set->count; i++) {
+        set->order[fill[set->templates[i].length & (IR_TEMPLATE_BUCKETS - 1)]++] = i;
+    }
+}
+
+// Distance of a frame to a template of the same length, the sum of all deviations.
+// Only the part of a deviation beyond 25% (TOLERANCE) counts against maxExcess, so
+// jitter does not rule a template out but still ranks it. Stops once bound is reached.
+static uint32_t templateDistance(ir_decode_results *results, const ir_template_t *candidate, uint16_t maxExcess, uint32_t bound) {
+    uint32_t distance = 0;
+    uint32_t excess = 0;
+
+    for (uint16_t i = 0; i < candidate->length && distance < bound; i++) {
+        uint16_t expected = candidate->durations[i];
+        uint16_t ticks = IR_RAW(results, i + 1);
+        uint16_t difference = ticks > expected ? ticks - expected : expected - ticks;
+        uint16_t band = expected / 4;
+        distance += difference;
+        if (difference > band) {
+            excess += difference - band;
+            if (excess > maxExcess) {
+                return UINT32_MAX;
+            }
+        }
+    }
+    return distance;
+}
+
+bool IR_templateMatch(const ir_template_set_t *set, ir_decode_results *results, uint16_t *action) {
+    if (results->rawlen < 2 || results->overflow) {
+        return false;
+    }
+    uint16_t length = results->rawlen - 1;
+    uint8_t bucket = length & (IR_TEMPLATE_BUCKETS - 1);
+    const ir_template_t *closest = NULL;
+    uint32_t best = UINT32_MAX;
+
+    for (uint16_t k = set->first[bucket]; k < set->first[bucket + 1]; k++) {
+        const ir_template_t *candidate = &set->templates[set->order[k]];
+        if (candidate->length != length) {
+            continue;
+        }
+        uint32_t distance = templateDistance(results, candidate, set->maxExcess, best);
+        if (distance < best) {
+            best = distance;
+            closest = candidate;
+            if (distance == 0) {
+                break;
+            }
+        }
+    }
+    if (!closest) {
+        return false;
+    }
+    *action = closest->action;
+    return true;
+}
+
+#endif // DECODE_HASH
@@ -0,0 +1,66 @@
+/**
+ * @file irProfile.c
+ * @brief Cycle counts of the receive ISRs and the decoders (USE_IR_PROFILE).
+ *
+ * Every measuring point keeps min, max, sum and a log2 histogram of its runs.
+ * The ISR points are recorded in interrupt context, so the task side copies
+ * them with interrupts disabled.
+ */
+
+#include "IRremote.h"
+
+#ifdef USE_IR_PROFILE
+
+static ir_profile_t profiles[IR_PROFILE_POINTS];
+
+//+=============================================================================
+// Index of the highest set bit, without CLZ which the Cortex-M0+ does not have
+//
+static uint8_t log2Bucket(uint32_t cycles) {
+    uint8_t bucket = 0;
+
+    if (cycles >= 1UL << 16) { cycles >>= 16; bucket += 16; }
+    if (cycles >= 1UL << 8)  { cycles >>= 8;  bucket += 8; }
+    if (cycles >= 1UL << 4)  { cycles >>= 4;  bucket += 4; }
+    if (cycles >= 1UL << 2)  { cycles >>= 2;  bucket += 2; }
+    if (cycles >= 1UL << 1)  { bucket += 1; }
+
+    return bucket < IR_PROFILE_BUCKETS ? bucket : IR_PROFILE_BUCKETS - 1;
+}
+
+void IR_profileReset(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(profiles, 0, sizeof(profiles));
+    __set_PRIMASK(primask);
+
+    IR_cycleCounterInit();
+}
+
+void IR_profileRecord(ir_profile_point_t point, uint32_t cycles) {
+    ir_profile_t *profile = &profiles[point];
+    uint16_t *bucket = &profile->histogram[log2Bucket(cycles)];
+
+    if (profile->count == 0 || cycles < profile->min) {
+        profile->min = cycles;
+    }
+    if (cycles > profile->max) {
+        profile->max = cycles;
+    }
+    profile->count++;
+    profile->sum += cycles;
+    if (*bucket != 0xFFFF) {
+        (*bucket)++;
+    }
+}
+
+bool IR_profileGet(ir_profile_point_t point, ir_profile_t *profile) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *profile = profiles[point];
+    __set_PRIMASK(primask);
+
+    return profile->count != 0;
+}
+
+#endif // USE_IR_PROFILE
@@ -110,9 +110,9 @@ static void dumpDuration(uint16_t duration, uint16_t timebase) {
     dumpNumber((duration * MICROS_PER_TICK + timebase / 2) / timebase);
 }
 
-static void dumpSequence(const volatile uint16_t *data, size_t length, uint16_t timebase) {
-    for (unsigned int i = 0; i < length; i++)
-        dumpDuration(data[i], timebase);
+static void dumpSequence(ir_decode_results *results, size_t start, uint16_t timebase) {
+    for (unsigned int i = start; i < results->rawlen; i++)
+        dumpDuration(IR_RAW(results, i), timebase);
 
     dumpDuration(_GAP, timebase);
 }
@@ -127,7 +127,7 @@ void dumpPronto(ir_decode_results *results, unsigned int frequency) {
     dumpNumber((results->rawlen + 1) / 2);
     dumpNumber(0);
     unsigned int timebase = toTimebase(frequency);
-    dumpSequence(results->rawbuf + RESULT_JUNK_COUNT, results->rawlen - RESULT_JUNK_COUNT, timebase);
+    dumpSequence(results, RESULT_JUNK_COUNT, timebase);
 }
 
 //+=============================================================================
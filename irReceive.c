@@ -2,218 +2,868 @@
 
 static bool IR_decodeHash(ir_decode_results *results);
 static int compare(unsigned int oldval, unsigned int newval);
+#ifdef IR_REPEAT_CACHE_MS
+static bool repeatCached(ir_receiver_t *receiver, ir_decode_results *results);
+static void cacheFrame(ir_receiver_t *receiver, ir_decode_results *results);
+#endif
+
+// Enclose every update of receiver->stats, see IR_receiverGetStats()
+static inline void beginStats(ir_receiver_t *receiver) {
+    receiver->stats.sequence++;
+    __DMB();
+}
 
+static inline void endStats(ir_receiver_t *receiver) {
+    __DMB();
+    receiver->stats.sequence++;
+}
 
+#ifdef USE_IR_EDGE_FIFO
 //+=============================================================================
-// Decodes the received IR message
-// Returns 0 if no data ready, 1 if data ready.
-// Results of decoding are stored in results
+// Count the entries the ISR could not push since the last call as one lost frame.
+// Called at both ends of a frame, so a frame which lost its end marker is counted
+// when the next one starts.
 //
-bool IR_decode(ir_decode_results *results) {
-    if (irparams.rcvstate != IR_REC_STATE_STOP) {
-        return false;
-    }
-    if (!results) {
+static bool countOverruns(ir_receiver_t *receiver) {
+    uint16_t overruns = receiver->params.edges.overruns;
+
+    if (receiver->edgeOverruns == overruns) {
         return false;
     }
+    receiver->edgeOverruns = overruns;
+    beginStats(receiver);
+    receiver->stats.overruns++;
+    endStats(receiver);
+    return true;
+}
 
-    /*
-     * First copy 3 values from irparams to internal results structure
-     */
-    results->rawbuf = irparams.rawbuf;
-    results->rawlen = irparams.rawlen;
-    results->overflow = irparams.overflow;
+//+=============================================================================
+// Drain the edge FIFO into receiver->edgeFrame.
+// Returns true as soon as a complete frame is assembled, the rest stays in the FIFO.
+// A frame which lost entries to a FIFO overrun is discarded.
+//
+static bool collectEdges(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
+    uint16_t entry;
 
-    // reset optional values
-    results->address = 0;
-    results->isRepeat = false;
+    while (IR_edgeFifoPop(&params->edges, &entry)) {
+#ifdef USE_IR_LONG_FRAMES
+        if (entry == IR_EDGE_LONG_FRAME_END) {
+            // Decoded by the ISR, only IR_available() looks at the durations
+            if (countOverruns(receiver) || receiver->edgeFrame.rawlen == 0) {
+                receiver->edgeFrame.overflow = true;
+            }
+            receiver->edgeFrameLong = true;
+            receiver->edgeFrameReady = true;
+            return true;
+        }
+#endif
+        if (entry == IR_EDGE_FRAME_END) {
+            if (countOverruns(receiver) || receiver->edgeFrame.rawlen == 0) {
+                receiver->edgeFrame.rawlen = 0;
+                continue;
+            }
+            receiver->edgeFrameReady = true;
+            return true;
+        }
+        if (entry & IR_EDGE_FRAME_START) {
+            countOverruns(receiver);
+            receiver->edgeFrame.overflow = false;
+            IR_rawStore(&receiver->edgeFrame, 0, entry & IR_EDGE_MAX_DURATION);
+            receiver->edgeFrame.rawlen = 1;
+#if defined(USE_IR_STREAM_DECODE) && IR_STREAM_PROTOCOLS > 0
+            IR_streamReset(&receiver->edgeStream);
+            receiver->edgeStreamLive = IR_streamFeed(&receiver->edgeStream, entry & IR_EDGE_MAX_DURATION);
+#endif
+        } else if (receiver->edgeFrame.rawlen == 0) {
+            // start of frame was lost, wait for the next one
+        } else {
+            if (receiver->edgeFrame.rawlen < RAW_BUFFER_LENGTH) {
+                IR_rawStore(&receiver->edgeFrame, receiver->edgeFrame.rawlen++, entry);
+#if defined(USE_IR_STREAM_DECODE) && IR_STREAM_PROTOCOLS > 0
+                if (receiver->edgeStreamLive) {
+                    receiver->edgeStreamLive = IR_streamFeed(&receiver->edgeStream, entry);
+                }
+#endif
+            } else {
+                receiver->edgeFrame.overflow = true;
+            }
+        }
+    }
+    return false;
+}
+#endif // USE_IR_EDGE_FIFO
 
-#if DECODE_NEC_STANDARD
-    DBG_PRINTLN("Attempting NEC_STANDARD decode");
-    if (IR_decodeNECStandard(results)) {
-        return true;
+//+=============================================================================
+// Returns the oldest received frame, or NULL if there is none.
+// The frame stays valid until IR_resume() is called.
+//
+static struct irframe_struct* nextFrame(ir_receiver_t *receiver) {
+#ifdef USE_IR_EDGE_FIFO
+    if (receiver->edgeFrameReady || collectEdges(receiver)) {
+        return &receiver->edgeFrame;
+    }
+#else
+    struct irparams_struct *params = &receiver->params;
+    if (IR_FRAMES_PENDING(params) != 0) {
+        return IR_DECODE_FRAME(params);
     }
 #endif
+    return NULL;
+}
 
-#if DECODE_NEC
-    DBG_PRINTLN("Attempting NEC decode");
-    if (IR_decodeNEC(results)) {
-        return true;
+
+//+=============================================================================
+// Count a decoded frame, UNKNOWN is the hash decoder
+//
+static void countDecoded(ir_receiver_t *receiver, ir_decode_type_t decode_type) {
+    beginStats(receiver);
+    if (decode_type == UNKNOWN) {
+        receiver->stats.hashed++;
+    } else if ((unsigned)decode_type < IR_DECODE_TYPES) {
+        receiver->stats.decoded[decode_type]++;
     }
-#endif
+    endStats(receiver);
+}
 
-#if DECODE_SHARP
-    DBG_PRINTLN("Attempting Sharp decode");
-    if (IR_decodeSharp(results)) {
-        return true;
+// Count a frame taken for decoding, if it is an overflowed one
+static void countOverflow(ir_receiver_t *receiver, ir_decode_results *results) {
+    if (results->overflow) {
+        beginStats(receiver);
+        receiver->stats.overflows++;
+        endStats(receiver);
     }
-#endif
+}
 
-#if DECODE_SHARP_ALT
-    DBG_PRINTLN("Attempting SharpAlt decode");
-    if (IR_decodeSharpAlt(results)) {
-        return true;
+#if DECODE_HASH
+// Resolve a hashed frame to the action learned for it, by its hash or else by the closest template
+static void lookupLearned(ir_receiver_t *receiver, ir_decode_results *results) {
+    if (results->decode_type != UNKNOWN) {
+        return;
+    }
+    if (receiver->learnedCodes && IR_learnedLookup(receiver->learnedCodes, results->value, &results->action)) {
+        return;
+    }
+    if (receiver->templates) {
+        IR_templateMatch(receiver->templates, results, &results->action);
     }
+}
+
+static const ir_decoder_t hashDecoder = {
+    .decode = IR_decodeHash,
+    .decode_type = UNKNOWN,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK(6, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
 
+// Decoders in the order they are tried. decodeHash returns a hash on any input,
+// thus it needs to be last in the list. If you add any decodes, add them before it.
+static const ir_decoder_t * const decoders[] = {
+#if DECODE_NEC_STANDARD
+    &IR_decoderNECStandard,
+#endif
+#if DECODE_NEC
+    &IR_decoderNEC,
+#endif
+#if DECODE_SHARP
+    &IR_decoderSharp,
+#endif
+#if DECODE_SHARP_ALT
+    &IR_decoderSharpAlt,
+#endif
 #if DECODE_SONY
-    DBG_PRINTLN("Attempting Sony decode");
-    if (IR_decodeSony(results)) {
-        return true;
-    }
+    &IR_decoderSony,
 #endif
-
 #if DECODE_SANYO
-    DBG_PRINTLN("Attempting Sanyo decode");
-    if (IR_decodeSanyo(results)) {
-        return true;
-    }
+    &IR_decoderSanyo,
 #endif
-
 #if DECODE_RC5
-    DBG_PRINTLN("Attempting RC5 decode");
-    if (IR_decodeRC5(results)) {
-        return true;
-    }
+    &IR_decoderRC5,
 #endif
-
 #if DECODE_RC6
-    DBG_PRINTLN("Attempting RC6 decode");
-    if (IR_decodeRC6(results)) {
-        return true;
-    }
+    &IR_decoderRC6,
 #endif
-
 #if DECODE_PANASONIC
-    DBG_PRINTLN("Attempting Panasonic decode");
-    if (IR_decodePanasonic(results)) {
-        return true;
-    }
+    &IR_decoderPanasonic,
 #endif
-
 #if DECODE_LG
-    DBG_PRINTLN("Attempting LG decode");
-    if (IR_decodeLG(results)) {
-        return true;
-    }
+    &IR_decoderLG,
 #endif
-
 #if DECODE_JVC
-    DBG_PRINTLN("Attempting JVC decode");
-    if (IR_decodeJVC(results)) {
-        return true;
-    }
+    &IR_decoderJVC,
 #endif
-
 #if DECODE_SAMSUNG
-    DBG_PRINTLN("Attempting SAMSUNG decode");
-    if (IR_decodeSAMSUNG(results)) {
-        return true;
+    &IR_decoderSAMSUNG,
+#endif
+#if DECODE_WHYNTER
+    &IR_decoderWhynter,
+#endif
+#if DECODE_DENON
+    &IR_decoderDenon,
+#endif
+#if DECODE_LEGO_PF
+    &IR_decoderLegoPowerFunctions,
+#endif
+#if DECODE_MAGIQUEST
+    &IR_decoderMagiQuest,
+#endif
+#if DECODE_HASH
+    &hashDecoder,
+#endif
+};
+
+#define DECODERS    (sizeof(decoders) / sizeof(decoders[0]))
+
+// Bit of a decoder in ir_protocol_mask_t, UNKNOWN is the hash decoder
+static inline ir_protocol_mask_t protocolBit(ir_decode_type_t decode_type) {
+    return decode_type == UNKNOWN ? IR_PROTOCOL_HASH : IR_PROTOCOL_BIT(decode_type);
+}
+
+static inline bool signatureMatches(const ir_signature_t *signature, uint16_t firstMark, uint16_t rawlen) {
+    return rawlen >= signature->minLength && rawlen <= signature->maxLength
+            && firstMark >= signature->markLow && firstMark <= signature->markHigh;
+}
+
+//+=============================================================================
+// Dispatch table on the first mark.
+// The mark axis is cut into cells of 1 << MARK_CELL_SHIFT ticks (128 us in input
+// capture mode, 200 us in periodic mode), the last cell takes all longer marks.
+// Each cell holds the set of decoders with a signature reaching into it, so one
+// load finds the candidates of a frame and signatureMatches() settles the exact
+// mark and length bounds. NEC, LG/JVC, Samsung and Panasonic headers land in
+// different cells, and the frames of most protocols meet one or two candidates.
+// The table is generated from the decoders[] signatures by IR_decodeInit(), before
+// the receive interrupt is enabled, or by the first decode on boards with their
+// own enable. It is only read afterwards.
+//
+typedef uint32_t decoder_set_t;     // bit i is decoders[i]
+
+_Static_assert(DECODERS <= 8 * sizeof(decoder_set_t), "decoder_set_t has a bit per decoder");
+
+#if MICROS_PER_TICK == 1
+#define MARK_CELL_SHIFT     7
+#else
+#define MARK_CELL_SHIFT     2
+#endif
+#define MARK_CELLS          96      // up to 12.2 ms in input capture mode, the NEC header is 9 ms
+
+static decoder_set_t markCells[MARK_CELLS];
+static bool markCellsReady;
+
+static inline bool signatureUsed(const ir_signature_t *signature) {
+    return signature->minLength <= signature->maxLength;
+}
+
+static inline uint8_t markCell(uint16_t ticks) {
+    uint16_t cell = ticks >> MARK_CELL_SHIFT;
+    return cell < MARK_CELLS ? cell : MARK_CELLS - 1;
+}
+
+// Decoders with a signature reaching into cell
+static decoder_set_t cellCandidates(uint8_t cell) {
+    decoder_set_t candidates = 0;
+
+    for (uint8_t i = 0; i < DECODERS; i++) {
+        for (uint8_t k = 0; k < 2; k++) {
+            const ir_signature_t *signature = &decoders[i]->signatures[k];
+            if (signatureUsed(signature) && cell >= markCell(signature->markLow) && cell <= markCell(signature->markHigh)) {
+                candidates |= (decoder_set_t) 1 << i;
+            }
+        }
+    }
+    return candidates;
+}
+
+// Every cell is written once with its final set, so the first decodes of two
+// receivers may both get here and still leave the same table behind.
+void IR_decodeInit(void) {
+    if (markCellsReady) {
+        return;
+    }
+    for (uint8_t cell = 0; cell < MARK_CELLS; cell++) {
+        markCells[cell] = cellCandidates(cell);
+    }
+    __DMB();
+    markCellsReady = true;
+}
+
+#ifdef USE_IR_EARLY_FRAME_END
+// Called by the ISR once the end of frame predictor has found a complete frame.
+// The candidates of the streaming decoder are settled by the predictor itself.
+bool IR_frameMayGrow(ir_protocol_mask_t disabledProtocols, uint16_t firstMark, uint16_t length) {
+    if (!markCellsReady) {
+        return true; // no table yet, wait for the gap
     }
+    decoder_set_t candidates = markCells[markCell(firstMark)];
+
+    for (uint8_t i = 0; candidates != 0; i++, candidates >>= 1) {
+        if (!(candidates & 1)) {
+            continue;
+        }
+        const ir_decoder_t *decoder = decoders[i];
+
+        // the hash decoder only gets the frames no decoder takes
+        if (decoder->decode_type == UNKNOWN
+                || ((disabledProtocols | IR_STREAM_PROTOCOL_MASK) & protocolBit(decoder->decode_type))) {
+            continue;
+        }
+        for (uint8_t k = 0; k < 2; k++) {
+            const ir_signature_t *signature = &decoder->signatures[k];
+            if (signatureUsed(signature) && signature->minLength > length
+                    && firstMark >= signature->markLow && firstMark <= signature->markHigh) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 #endif
 
-#if DECODE_WHYNTER
-    DBG_PRINTLN("Attempting Whynter decode");
-    if (IR_decodeWhynter(results)) {
-        return true;
+//+=============================================================================
+// Dispatch stage of IR_decode().
+// The frame is classified once by its first mark and length. Only decoders with
+// a matching signature are called, so a frame no longer pays for every decoder
+// which would fail on the header anyway.
+//
+static bool dispatchFrame(ir_receiver_t *receiver, ir_decode_results *results) {
+    uint16_t rawlen = results->rawlen;
+    uint16_t firstMark = rawlen > 1 ? IR_RAW(results, 1) : 0;
+
+    if (!markCellsReady) {
+        IR_decodeInit();
     }
+    decoder_set_t candidates = markCells[markCell(firstMark)];
+
+    for (uint8_t i = 0; candidates != 0; i++, candidates >>= 1) {
+        if (!(candidates & 1)) {
+            continue;
+        }
+        const ir_decoder_t *decoder = decoders[i];
+
+        if (receiver->disabledProtocols & protocolBit(decoder->decode_type)) {
+            continue;
+        }
+        if (!signatureMatches(&decoder->signatures[0], firstMark, rawlen)
+                && !signatureMatches(&decoder->signatures[1], firstMark, rawlen)) {
+            continue;
+        }
+        DBG_PRINT("Attempting decode of type %d\r\n", decoder->decode_type);
+#ifdef USE_IR_PROFILE
+        IR_PROFILE_BEGIN(start);
+        bool decoded = decoder->decode(results);
+        IR_PROFILE_END(decoder->decode_type == UNKNOWN ? IR_PROFILE_HASH : IR_PROFILE_DECODER + decoder->decode_type, start);
+#else
+        bool decoded = decoder->decode(results);
 #endif
+        if (decoded) {
+            countDecoded(receiver, decoder->decode_type);
+            return true;
+        }
+    }
+    return false;
+}
 
-#if DECODE_DENON
-    DBG_PRINTLN("Attempting Denon decode");
-    if (IR_decodeDenon(results)) {
+//+=============================================================================
+// Decodes the received IR message
+// Returns 0 if no data ready, 1 if data ready.
+// Results of decoding are stored in results
+//
+bool IR_receiverDecode(ir_receiver_t *receiver, ir_decode_results *results) {
+    if (!results) {
+        return false;
+    }
+    struct irframe_struct *frame = nextFrame(receiver);
+    if (!frame) {
+        return false;
+    }
+
+    /*
+     * First copy 3 values from the oldest frame to internal results structure
+     */
+    results->rawbuf = frame->rawbuf;
+#ifdef USE_IR_COMPACT_RAWBUF
+    results->rawlong = frame->rawlong;
+#endif
+    results->rawlen = frame->rawlen;
+    results->overflow = frame->overflow;
+    results->state = &receiver->decoderState;
+#if DECODE_HASH
+    results->action = IR_LEARNED_NONE;
+#endif
+#ifdef USE_IR_LONG_FRAMES
+    results->data = NULL;
+    // Checked first, a long frame has most likely overflowed rawbuf
+    const ir_protocol_t *longProtocol = receiver->longFrame.protocol;
+    if (receiver->edgeFrameLong && longProtocol && !(receiver->disabledProtocols & protocolBit(longProtocol->decode_type))
+            && IR_longFrameResult(&receiver->longFrame, results)) {
+        countDecoded(receiver, results->decode_type);
         return true;
     }
 #endif
+    countOverflow(receiver, results);
+#ifdef USE_IR_COMPACT_RAWBUF
+    if (frame->clipped) {
+        // A long duration was lost, the decoders and the hash would read a wrong one
+        beginStats(receiver);
+        receiver->stats.unknown++;
+        endStats(receiver);
+        IR_receiverResume(receiver);
+        return false;
+    }
+#endif
 
-#if DECODE_LEGO_PF
-    DBG_PRINTLN("Attempting Lego Power Functions");
-    if (IR_decodeLegoPowerFunctions(results)) {
-        return true;
+    // reset optional values
+    results->address = 0;
+    results->isRepeat = false;
+
+#if defined(USE_IR_STREAM_DECODE) && IR_STREAM_PROTOCOLS > 0
+    // Result of the streaming decoder is already there, no need to scan the frame again
+    if (receiver->edgeStreamLive && !results->overflow) {
+        IR_PROFILE_BEGIN(start);
+        bool decoded = IR_streamResult(&receiver->edgeStream, results);
+        IR_PROFILE_END(IR_PROFILE_STREAM_RESULT, start);
+        if (decoded) {
+            countDecoded(receiver, results->decode_type);
+#ifdef IR_REPEAT_CACHE_MS
+            cacheFrame(receiver, results);
+#endif
+            return true;
+        }
     }
 #endif
 
-#if DECODE_MAGIQUEST
-    DBG_PRINTLN("Attempting MagiQuest decode");
-    if (IR_decodeMagiQuest(results)) {
+#ifdef IR_REPEAT_CACHE_MS
+    if (repeatCached(receiver, results)) {
+#if DECODE_HASH
+        lookupLearned(receiver, results);
+#endif
         return true;
     }
 #endif
 
+    if (dispatchFrame(receiver, results)) {
+#ifdef IR_REPEAT_CACHE_MS
+        cacheFrame(receiver, results);
+#endif
 #if DECODE_HASH
-    DBG_PRINTLN("Hash decode");
-    // decodeHash returns a hash on any input.
-    // Thus, it needs to be last in the list.
-    // If you add any decodes, add them before this.
-    if (IR_decodeHash(results)) {
+        lookupLearned(receiver, results);
+#endif
         return true;
     }
-#endif
 
     // Throw away and start over
-    IR_resume();
+    beginStats(receiver);
+    receiver->stats.unknown++;
+    endStats(receiver);
+    IR_receiverResume(receiver);
     return false;
 }
 
+bool IR_decode(ir_decode_results *results) {
+    return IR_receiverDecode(&IR_defaultReceiver, results);
+}
+
 //+=============================================================================
 // initialization
 //
 #ifdef USE_DEFAULT_ENABLE_IR_IN
-void IR_enableIRIn(void) {
-    // Setup timer mode and interrupts
-    TIMER_DISABLE_RECEIVE_INTR;
-    IR_timerConfigForReceive();
-    TIMER_ENABLE_RECEIVE_INTR;
+void IR_receiverEnable(ir_receiver_t *receiver) {
+    struct irparams_struct *params = &receiver->params;
 
     // Initialize state machine state
-    irparams.rcvstate = IR_REC_STATE_IDLE;
-    irparams.rawlen = 0;
+    params->rcvstate = IR_REC_STATE_IDLE;
+#ifdef USE_TIMER_DMA_MODE
+    params->dmaRead = 0;
+    params->lastEdge = 0;
+    params->dmaMark = false;
+    params->dmaLongGap = false;
+#endif
+#ifdef USE_TIMER_IC_FREE_RUNNING
+    params->overflows = 0;
+    params->lastCapture = 0;
+#endif
+    params->dropping = false;
+    memset(&params->stats, 0, sizeof(params->stats));
+    memset(&receiver->stats, 0, sizeof(receiver->stats));
+    memset(&receiver->decoderState, 0, sizeof(receiver->decoderState));
+#ifdef IR_REPEAT_CACHE_MS
+    receiver->repeatCache.rawlen = 0;
+#endif
+#ifdef IR_STORM_EDGES
+    params->storming = false;
+    params->stormEdges = 0;
+    params->stormBackoff = IR_STORM_BACKOFF_MS;
+    params->stormTime = millis();
+#endif
+#ifdef USE_IR_EDGE_FIFO
+    params->edges.head = 0;
+    params->edges.tail = 0;
+    params->edges.overruns = 0;
+    receiver->edgeOverruns = 0;
+    receiver->edgeFrame.rawlen = 0;
+    receiver->edgeFrameReady = false;
+#ifdef USE_IR_LONG_FRAMES
+    receiver->edgeFrameLong = false;
+    params->longFrameReady = false;
+#endif
+#else
+    params->head = 0;
+    params->tail = 0;
+    IR_CAPTURE_FRAME(params)->rawlen = 0;
+#endif
+
+    // Setup timer mode and interrupts
+    NVIC_DisableIRQ(receiver->hw.irqn);
+    IR_decodeInit();
+#ifdef USE_TIMER_DMA_MODE
+    IR_dmaConfigForReceive(&receiver->hw, params->timestamps, IR_DMA_BUFFER_LENGTH);
+#endif
+    IR_timerConfigForReceive(&receiver->hw);
+    NVIC_EnableIRQ(receiver->hw.irqn);
+}
+
+void IR_receiverDisable(ir_receiver_t *receiver) {
+    NVIC_DisableIRQ(receiver->hw.irqn);
+#ifdef USE_TIMER_DMA_MODE
+    NVIC_DisableIRQ(receiver->hw.dmaIrqn);
+#endif
+}
+
+void IR_enableIRIn(void) {
+#ifdef USE_IR_PROFILE
+    IR_profileReset();
+#endif
+    IR_receiverEnable(&IR_defaultReceiver);
 }
 
 void IR_disableIRIn(void) {
-    TIMER_DISABLE_RECEIVE_INTR;
+    IR_receiverDisable(&IR_defaultReceiver);
 }
 #endif // USE_DEFAULT_ENABLE_IR_IN
 
+//+=============================================================================
+// Frame notification.
+// The ISR only reads the fields. The thread is cleared while its signals are
+// changed, so the ISR never sees a thread with the signals of another one.
+//
+void IR_receiverSetFrameCallback(ir_receiver_t *receiver, ir_frame_callback_t callback) {
+    receiver->frameCallback = callback;
+}
+
+void IR_receiverSetFrameSignal(ir_receiver_t *receiver, osThreadId thread, int32_t signals) {
+    receiver->notifyThread = NULL;
+    __DMB();
+    receiver->notifySignals = signals;
+    __DMB();
+    receiver->notifyThread = thread;
+}
+
+void IR_setFrameCallback(ir_frame_callback_t callback) {
+    IR_receiverSetFrameCallback(&IR_defaultReceiver, callback);
+}
+
+void IR_setFrameSignal(osThreadId thread, int32_t signals) {
+    IR_receiverSetFrameSignal(&IR_defaultReceiver, thread, signals);
+}
+
 //+=============================================================================
 // Enable/disable blinking of BLINKLED pin 
 //
 void IR_blink(bool blinkflag) {
 #ifdef BLINKLED
-    irparams.blinkflag = blinkflag;
+    IR_defaultReceiver.params.blinkflag = blinkflag;
 #endif
 }
 
 //+=============================================================================
 // Return if receiving new IR signals
 //
+bool IR_receiverIsIdle(ir_receiver_t *receiver) {
+    uint8_t rcvstate = receiver->params.rcvstate;
+    return (rcvstate == IR_REC_STATE_IDLE || rcvstate == IR_REC_STATE_STOP) ? true : false;
+}
+
 bool IR_isIdle(void) {
-    return (irparams.rcvstate == IR_REC_STATE_IDLE || irparams.rcvstate == IR_REC_STATE_STOP) ? true : false;
+    return IR_receiverIsIdle(&IR_defaultReceiver);
 }
 
-bool IR_available(ir_decode_results *results) {
-    if (irparams.rcvstate != IR_REC_STATE_STOP) {
+bool IR_receiverAvailable(ir_receiver_t *receiver, ir_decode_results *results) {
+    struct irframe_struct *frame = nextFrame(receiver);
+    if (!frame) {
         return false;
     }
-    results->rawbuf = irparams.rawbuf;
-    results->rawlen = irparams.rawlen;
+    results->rawbuf = frame->rawbuf;
+#ifdef USE_IR_COMPACT_RAWBUF
+    results->rawlong = frame->rawlong;
+#endif
+    results->rawlen = frame->rawlen;
 
-    results->overflow = irparams.overflow;
+    results->overflow = frame->overflow;
+    results->state = &receiver->decoderState;
+#ifdef USE_IR_LONG_FRAMES
+    results->data = NULL;
+#endif
     if (!results->overflow) {
         return true;
     }
-    IR_resume(); //skip overflowed buffer
+    countOverflow(receiver, results);
+    IR_receiverResume(receiver); //skip overflowed buffer
     return false;
 }
 
+bool IR_available(ir_decode_results *results) {
+    return IR_receiverAvailable(&IR_defaultReceiver, results);
+}
+
+bool IR_receiverFramePending(ir_receiver_t *receiver) {
+    return nextFrame(receiver) != NULL;
+}
+
+bool IR_framePending(void) {
+    return IR_receiverFramePending(&IR_defaultReceiver);
+}
+
 //+=============================================================================
-// Restart the ISR state machine
+// Release the oldest frame and restart the ISR state machine if it was
+// stopped because the ring was full.
+// If the ISR is currently dropping a frame, it restarts by itself at the next gap.
 //
+void IR_receiverResume(ir_receiver_t *receiver) {
+#ifdef USE_IR_EDGE_FIFO
+    // The ISR does not depend on the decoder, just release the assembled frame
+    receiver->edgeFrameReady = false;
+    receiver->edgeFrame.rawlen = 0;
+#ifdef USE_IR_LONG_FRAMES
+    if (receiver->edgeFrameLong) {
+        // Hand the long frame decoder back to the ISR, which resets it with the next frame
+        receiver->edgeFrameLong = false;
+        receiver->longFrame.live = false;
+        __DMB();
+        receiver->params.longFrameReady = false;
+    }
+#endif
+#else
+    struct irparams_struct *params = &receiver->params;
+
+    if (IR_FRAMES_PENDING(params) == 0) {
+        return;
+    }
+    params->tail++;
+    if (params->rcvstate == IR_REC_STATE_STOP && !params->dropping) {
+        params->rcvstate = IR_REC_STATE_IDLE;
+    }
+#endif
+}
+
 void IR_resume(void) {
-    irparams.rcvstate = IR_REC_STATE_IDLE;
-    irparams.rawlen = 0;
+    IR_receiverResume(&IR_defaultReceiver);
+}
+
+//+=============================================================================
+// Health counters.
+// Both counter blocks have a single writer, the ISR and the decoding task.
+// A copy is retried until the sequence of its block was even and unchanged,
+// so it never mixes counts from before and after an update.
+//
+void IR_receiverGetStats(ir_receiver_t *receiver, ir_receiver_stats_t *stats) {
+    struct irisrstats_struct *isr = &receiver->params.stats;
+    struct irdecodestats_struct *decode = &receiver->stats;
+    uint32_t sequence;
+
+    do {
+        sequence = isr->sequence;
+        __DMB();
+        stats->frames = isr->frames;
+        stats->edges = isr->edges;
+        stats->dropped = isr->dropped;
+        stats->storms = isr->storms;
+        __DMB();
+    } while ((sequence & 1) || sequence != isr->sequence);
+
+    do {
+        sequence = decode->sequence;
+        __DMB();
+        stats->overruns = decode->overruns;
+        stats->overflows = decode->overflows;
+        stats->unknown = decode->unknown;
+        stats->hashed = decode->hashed;
+        stats->cached = decode->cached;
+        memcpy(stats->decoded, decode->decoded, sizeof(stats->decoded));
+        __DMB();
+    } while ((sequence & 1) || sequence != decode->sequence);
+}
+
+void IR_getStats(ir_receiver_stats_t *stats) {
+    IR_receiverGetStats(&IR_defaultReceiver, stats);
+}
+
+uint32_t IR_receiverDroppedFrames(ir_receiver_t *receiver) {
+    ir_receiver_stats_t stats;
+    IR_receiverGetStats(receiver, &stats);
+    return stats.dropped + stats.overruns;
+}
+
+uint32_t IR_getDroppedFrames(void) {
+    return IR_receiverDroppedFrames(&IR_defaultReceiver);
+}
+
+//+=============================================================================
+// Protocol selection.
+// The mask is kept inverted, so a zero initialized receiver decodes everything.
+//
+void IR_receiverSetProtocols(ir_receiver_t *receiver, ir_protocol_mask_t protocols) {
+    receiver->disabledProtocols = ~protocols & IR_PROTOCOLS_ALL;
+#ifdef IR_REPEAT_CACHE_MS
+    receiver->repeatCache.rawlen = 0; // may hold a protocol which is disabled now
+#endif
+#if defined(USE_IR_EDGE_FIFO) && defined(USE_IR_STREAM_DECODE) && IR_STREAM_PROTOCOLS > 0
+    IR_streamSetProtocols(&receiver->edgeStream, protocols);
+#endif
+#ifdef USE_IR_EARLY_FRAME_END
+    // taken over by the ISR with the next frame
+    receiver->params.frameEnd.disabled = IR_streamDisabled(protocols);
+    receiver->params.frameEnd.disabledProtocols = receiver->disabledProtocols;
+#endif
 }
 
+ir_protocol_mask_t IR_receiverGetProtocols(ir_receiver_t *receiver) {
+    return ~receiver->disabledProtocols & IR_PROTOCOLS_ALL;
+}
+
+void IR_setProtocols(ir_protocol_mask_t protocols) {
+    IR_receiverSetProtocols(&IR_defaultReceiver, protocols);
+}
+
+ir_protocol_mask_t IR_getProtocols(void) {
+    return IR_receiverGetProtocols(&IR_defaultReceiver);
+}
+
+#if DECODE_HASH
+void IR_receiverSetLearnedCodes(ir_receiver_t *receiver, const ir_learned_table_t *table) {
+    receiver->learnedCodes = table;
+}
+
+void IR_setLearnedCodes(const ir_learned_table_t *table) {
+    IR_receiverSetLearnedCodes(&IR_defaultReceiver, table);
+}
+
+void IR_receiverSetTemplates(ir_receiver_t *receiver, const ir_template_set_t *set) {
+    receiver->templates = set;
+}
+
+void IR_setTemplates(const ir_template_set_t *set) {
+    IR_receiverSetTemplates(&IR_defaultReceiver, set);
+}
+#endif
+
+#ifdef USE_IR_LONG_FRAMES
+//+=============================================================================
+// Long frames.
+// The ISR feeds the decoder. Once it has pushed IR_EDGE_LONG_FRAME_END, it leaves
+// the decoder to the task until IR_resume() clears params.longFrameReady.
+//
+void IR_receiverSetLongFrames(ir_receiver_t *receiver, const ir_protocol_t *protocol, uint8_t *buffer, uint16_t size) {
+    ir_long_frame_decoder *decoder = &receiver->longFrame;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    decoder->protocol = protocol;
+    decoder->buffer = buffer;
+    decoder->size = size;
+    decoder->live = false; // from the next frame on
+    receiver->params.longFrame = decoder;
+    __set_PRIMASK(primask);
+}
+
+void IR_setLongFrames(const ir_protocol_t *protocol, uint8_t *buffer, uint16_t size) {
+    IR_receiverSetLongFrames(&IR_defaultReceiver, protocol, buffer, size);
+}
+#endif
+
+#ifdef IR_STORM_EDGES
+uint32_t IR_receiverStorms(ir_receiver_t *receiver) {
+    return receiver->params.stats.storms;
+}
+
+uint32_t IR_getStorms(void) {
+    return IR_receiverStorms(&IR_defaultReceiver);
+}
+#endif
+
+#ifdef IR_REPEAT_CACHE_MS
+//+=============================================================================
+// Repeat cache.
+// The durations of the last fully decoded frame are kept together with its result.
+// A frame of the same length whose marks and spaces are all within TOLERANCE (25%)
+// of the kept ones is a held key, as long as it arrives within IR_REPEAT_CACHE_MS
+// of the previous one. The gap in front of the frame is not compared.
+// Sony, Sanyo and Sharp Alt take a frame after a short gap for a repeat, and Sharp Alt
+// also skips the first repeat by state kept across frames, so their decoders see every
+// frame. Hashed frames are not cached either, any frame of the same length would do.
+//
+#define REPEAT_CACHE_EXCLUDED   (IR_PROTOCOL_BIT(SONY) | IR_PROTOCOL_BIT(SANYO) | IR_PROTOCOL_BIT(SHARP_ALT) | IR_PROTOCOL_HASH)
+
+// Remember a successful decode, repeats and overflowed frames are not worth it
+static void cacheFrame(ir_receiver_t *receiver, ir_decode_results *results) {
+    struct irrepeatcache_struct *cache = &receiver->repeatCache;
+
+    if (results->isRepeat || results->overflow || results->rawlen < 4
+            || (protocolBit(results->decode_type) & REPEAT_CACHE_EXCLUDED)) {
+        cache->rawlen = 0;
+        return;
+    }
+    for (uint16_t i = 1; i < results->rawlen; i++) {
+        cache->durations[i] = IR_RAW(results, i);
+    }
+    cache->rawlen = results->rawlen;
+    cache->time = millis();
+    cache->decode_type = results->decode_type;
+    cache->address = results->address;
+    cache->value = results->value;
+    cache->bits = results->bits;
+    cache->magnitude = results->magnitude;
+}
+
+// Answer a repeated frame from the cache. A different key fails at its first
+// differing bit, so a miss usually costs a few entries only.
+static bool repeatCached(ir_receiver_t *receiver, ir_decode_results *results) {
+    struct irrepeatcache_struct *cache = &receiver->repeatCache;
+
+    if (cache->rawlen != results->rawlen || cache->rawlen == 0 || results->overflow) {
+        return false;
+    }
+    uint32_t now = millis();
+    if (now - cache->time > IR_REPEAT_CACHE_MS) {
+        cache->rawlen = 0;
+        return false;
+    }
+    for (uint16_t i = 1; i < results->rawlen; i++) {
+        uint16_t cached = cache->durations[i];
+        uint16_t ticks = IR_RAW(results, i);
+        uint16_t difference = ticks > cached ? ticks - cached : cached - ticks;
+        if (difference > cached / 4 + 1) {
+            return false;
+        }
+    }
+
+    cache->time = now;
+    results->decode_type = cache->decode_type;
+    results->address = cache->address;
+    results->value = cache->value;
+    results->bits = cache->bits;
+    results->magnitude = cache->magnitude;
+    results->isRepeat = true;
+    beginStats(receiver);
+    receiver->stats.cached++;
+    endStats(receiver);
+    countDecoded(receiver, results->decode_type);
+    return true;
+}
+#endif // IR_REPEAT_CACHE_MS
+
 # if DECODE_HASH
 //+=============================================================================
 // hashdecode - decode an arbitrary IR code.
@@ -242,64 +892,6 @@ static int compare(unsigned int oldval, unsigned int newval) {
     return 1;
 }
 
-/*
- * Decode pulse distance protocols.
- * The mark (pulse) has constant length, the length of the space determines the bit value.
- * Each bit looks like: MARK + SPACE_1 -> 1
- *                 or : MARK + SPACE_0 -> 0
- * Data is read MSB first if not otherwise enabled.
- * Input is     results->rawbuf
- * Output is    results->value
- */
-bool IR_decodePulseDistanceData(ir_decode_results *results, uint8_t aNumberOfBits, uint8_t aStartOffset, unsigned int aBitMarkMicros,
-        unsigned int aOneSpaceMicros, unsigned int aZeroSpaceMicros, bool aMSBfirst) {
-    unsigned long tDecodedData = 0;
-
-    if (aMSBfirst) {
-        for (uint8_t i = 0; i < aNumberOfBits; i++) {
-            // Check for constant length mark
-            if (!MATCH_MARK(results->rawbuf[aStartOffset], aBitMarkMicros)) {
-                return false;
-            }
-            aStartOffset++;
-
-            // Check for variable length space indicating a 0 or 1
-            if (MATCH_SPACE(results->rawbuf[aStartOffset], aOneSpaceMicros)) {
-                tDecodedData = (tDecodedData << 1) | 1;
-            } else if (MATCH_SPACE(results->rawbuf[aStartOffset], aZeroSpaceMicros)) {
-                tDecodedData = (tDecodedData << 1) | 0;
-            } else {
-                return false;
-            }
-            aStartOffset++;
-        }
-    }
-#if defined(LSB_FIRST_REQUIRED)
-    else {
-        for (unsigned long mask = 1UL; aNumberOfBits > 0; mask <<= 1, aNumberOfBits--) {
-            // Check for constant length mark
-            if (!MATCH_MARK(results->rawbuf[aStartOffset], aBitMarkMicros)) {
-                return false;
-            }
-            aStartOffset++;
-
-            // Check for variable length space indicating a 0 or 1
-            if (MATCH_SPACE(results->rawbuf[aStartOffset], aOneSpaceMicros)) {
-                tDecodedData |= mask; // set the bit
-            } else if (MATCH_SPACE(results->rawbuf[aStartOffset], aZeroSpaceMicros)) {
-                // do not set the bit
-            } else {
-                return false;
-            }
-
-            aStartOffset++;
-        }
-    }
-#endif
-    results->value = tDecodedData;
-    return true;
-}
-
 //+=============================================================================
 // Use FNV hash algorithm: http://isthe.com/chongo/tech/comp/fnv/#FNV-param
 // Converts the raw code values into a 32-bit hash code.
@@ -318,7 +910,7 @@ static bool IR_decodeHash(ir_decode_results *results) {
     }
 
     for (unsigned int i = 1; (i + 2) < results->rawlen; i++) {
-        int value = compare(results->rawbuf[i], results->rawbuf[i + 2]);
+        int value = compare(IR_RAW(results, i), IR_RAW(results, i + 2));
         // Add value into the hash
         hash = (hash * FNV_PRIME_32) ^ value;
     }
@@ -331,6 +923,193 @@ static bool IR_decodeHash(ir_decode_results *results) {
 }
 #endif // defined(DECODE_HASH)
 
+/*
+ * Mark/space pairs are classified word parallel (SWAR): the mark goes into the
+ * low and the space into the high half of a word, each a 15 bit lane below a
+ * guard bit. Durations above 0x7FFF ticks never match.
+ */
+#define SWAR_GUARDS     0x80008000UL
+#define SWAR_LANE_MAX   0x7FFFU
+
+// Lower bound and span of a tick range, clamped to a lane
+static inline uint32_t swarLow(const ir_ticks_t *aTicks) {
+    return (aTicks->low < SWAR_LANE_MAX) ? aTicks->low : SWAR_LANE_MAX;
+}
+
+static inline uint32_t swarSpan(const ir_ticks_t *aTicks) {
+    uint32_t tHigh = (aTicks->high < SWAR_LANE_MAX) ? aTicks->high : SWAR_LANE_MAX;
+    uint32_t tLow = swarLow(aTicks);
+    return (tHigh > tLow) ? tHigh - tLow : 0;
+}
+
+/*
+ * Guard bits of the lanes of aPair which lie within [aLow, aLow + aSpan].
+ * Setting the guards first keeps borrows inside their lanes, a guard survives
+ * the first subtraction if its lane is >= low, and the second if it is <= low + span.
+ */
+static inline uint32_t swarInRange(uint32_t aPair, uint32_t aLow, uint32_t aSpan) {
+    uint32_t tAbove = (aPair | SWAR_GUARDS) - aLow;
+    uint32_t tBelow = (aSpan | SWAR_GUARDS) - (tAbove & ~SWAR_GUARDS);
+    return tAbove & tBelow & ~aPair & SWAR_GUARDS;
+}
+
+// Reverse the bit order of a word, there is no RBIT before Cortex-M3
+static inline uint32_t reverseBits(uint32_t aValue) {
+#if __CORTEX_M >= 3
+    return __RBIT(aValue);
+#else
+    aValue = ((aValue >> 1) & 0x55555555UL) | ((aValue & 0x55555555UL) << 1);
+    aValue = ((aValue >> 2) & 0x33333333UL) | ((aValue & 0x33333333UL) << 2);
+    aValue = ((aValue >> 4) & 0x0F0F0F0FUL) | ((aValue & 0x0F0F0F0FUL) << 4);
+    aValue = ((aValue >> 8) & 0x00FF00FFUL) | ((aValue & 0x00FF00FFUL) << 8);
+    return (aValue >> 16) | (aValue << 16);
+#endif
+}
+
+/*
+ * Decode pulse distance protocols.
+ * The mark (pulse) has constant length, the length of the space determines the bit value.
+ * Each bit looks like: MARK + SPACE_1 -> 1
+ *                 or : MARK + SPACE_0 -> 0
+ * Input is     results->rawbuf
+ * Output is    results->value
+ * The durations are given as precomputed tick ranges. Every pair is checked
+ * against mark + 1 space and mark + 0 space at once, a 1 wins if both spaces
+ * match. Bits are collected MSB first and reversed once at the end for LSB first.
+ */
+static bool decodePulseDistanceTicks(ir_decode_results *results, uint8_t aNumberOfBits, uint8_t aStartOffset,
+        const ir_ticks_t *aBitMark, const ir_ticks_t *aOneSpace, const ir_ticks_t *aZeroSpace, bool aMSBfirst) {
+    uint32_t tOneLow = swarLow(aBitMark) | (swarLow(aOneSpace) << 16);
+    uint32_t tOneSpan = swarSpan(aBitMark) | (swarSpan(aOneSpace) << 16);
+    uint32_t tZeroLow = swarLow(aBitMark) | (swarLow(aZeroSpace) << 16);
+    uint32_t tZeroSpan = swarSpan(aBitMark) | (swarSpan(aZeroSpace) << 16);
+    uint32_t tDecodedData = 0;
+
+    for (uint8_t i = 0; i < aNumberOfBits; i++, aStartOffset += 2) {
+        // Entries are 16 bit aligned only, so the pair is loaded as two halves
+        uint32_t tPair = IR_RAW(results, aStartOffset) | ((uint32_t) IR_RAW(results, aStartOffset + 1) << 16);
+        uint32_t tOne = swarInRange(tPair, tOneLow, tOneSpan);
+        uint32_t tZero = swarInRange(tPair, tZeroLow, tZeroSpan);
+
+        // Bit 31 is left if the mark (guard 15) and either space (guard 31) match
+        if (((tOne << 16) & (tOne | tZero)) == 0) {
+            return false;
+        }
+        tDecodedData = (tDecodedData << 1) | (tOne >> 31);
+    }
+    if (!aMSBfirst && aNumberOfBits > 0 && aNumberOfBits <= 32) {
+        tDecodedData = reverseBits(tDecodedData) >> (32 - aNumberOfBits);
+    }
+    results->value = tDecodedData;
+    return true;
+}
+
+/*
+ * Same with the durations in microseconds, for the hand written decoders.
+ * The tick ranges are computed once per call instead of once per entry.
+ */
+bool IR_decodePulseDistanceData(ir_decode_results *results, uint8_t aNumberOfBits, uint8_t aStartOffset, unsigned int aBitMarkMicros,
+        unsigned int aOneSpaceMicros, unsigned int aZeroSpaceMicros, bool aMSBfirst) {
+    ir_ticks_t bitMark = IR_MARK_TICKS(aBitMarkMicros);
+    ir_ticks_t oneSpace = IR_SPACE_TICKS(aOneSpaceMicros);
+    ir_ticks_t zeroSpace = IR_SPACE_TICKS(aZeroSpaceMicros);
+
+    return decodePulseDistanceTicks(results, aNumberOfBits, aStartOffset, &bitMark, &oneSpace, &zeroSpace, aMSBfirst);
+}
+
+//+=============================================================================
+// Generic decoder for the protocols described by an ir_protocol_t.
+// Checks the repeat forms, the length, the optional lead-in and header, reads
+// address and data with decodePulseDistanceTicks() and checks stop bit and
+// command complement as the flags ask for.
+//
+static bool decodedRepeat(ir_decode_results *results, const ir_protocol_t *protocol) {
+    results->bits = 0;
+    results->value = REPEAT;
+    results->isRepeat = true;
+    results->decode_type = protocol->decode_type;
+    return true;
+}
+
+bool IR_decodeProtocol(ir_decode_results *results, const ir_protocol_t *protocol) {
+    uint16_t length = IR_protocolLength(protocol);
+    bool msbFirst = protocol->flags & IR_PROTOCOL_MSB_FIRST;
+    uint8_t offset = 1; // Skip the gap
+
+    // Repeat is header mark, repeat space and one bit mark
+    if (protocol->repeatSpace.high && results->rawlen == 4) {
+        if (IR_matchTicks(IR_RAW(results, 1), &protocol->headerMark)
+                && IR_matchTicks(IR_RAW(results, 2), &protocol->repeatSpace)
+                && IR_matchTicks(IR_RAW(results, 3), &protocol->bitMark)) {
+            return decodedRepeat(results, protocol);
+        }
+        return false;
+    }
+
+    // Repeat is the frame without its header
+    if ((protocol->flags & IR_PROTOCOL_HEADERLESS_REPEAT) && results->rawlen == length - 2) {
+        if (IR_matchTicks(IR_RAW(results, 1), &protocol->bitMark)
+                && IR_matchTicks(IR_RAW(results, results->rawlen - 1), &protocol->bitMark)) {
+            return decodedRepeat(results, protocol);
+        }
+        return false;
+    }
+
+    if ((protocol->flags & IR_PROTOCOL_EXACT_LENGTH) ? results->rawlen != length : results->rawlen < length) {
+        return false;
+    }
+
+    if (protocol->flags & IR_PROTOCOL_LEAD_IN) {
+        if (!IR_matchTicks(IR_RAW(results, offset), &protocol->bitMark)
+                || !IR_matchTicks(IR_RAW(results, offset + 1), &protocol->zeroSpace)) {
+            return false;
+        }
+        offset += 2;
+    }
+
+    if (protocol->headerMark.high) {
+        if (!IR_matchTicks(IR_RAW(results, offset), &protocol->headerMark)
+                || !IR_matchTicks(IR_RAW(results, offset + 1), &protocol->headerSpace)) {
+            return false;
+        }
+        offset += 2;
+    }
+
+    if (protocol->addressBits) {
+        if (!decodePulseDistanceTicks(results, protocol->addressBits, offset, &protocol->bitMark,
+                &protocol->oneSpace, &protocol->zeroSpace, msbFirst)) {
+            return false;
+        }
+        results->address = results->value;
+        offset += 2 * protocol->addressBits;
+    }
+
+    uint8_t dataBits = protocol->bits - protocol->addressBits;
+    if (!decodePulseDistanceTicks(results, dataBits, offset, &protocol->bitMark,
+            &protocol->oneSpace, &protocol->zeroSpace, msbFirst)) {
+        return false;
+    }
+    offset += 2 * dataBits;
+
+    if ((protocol->flags & IR_PROTOCOL_STOP_BIT) && !IR_matchTicks(IR_RAW(results, offset), &protocol->bitMark)) {
+        DBG_PRINT("Stop bit verify failed\r\n");
+        return false;
+    }
+
+    if (protocol->flags & IR_PROTOCOL_INVERTED_COMMAND) {
+        uint8_t command = results->value;
+        uint8_t inverted = results->value >> 8;
+        if ((command ^ inverted) != 0xFF) {
+            return false;
+        }
+        results->value = command;
+    }
+
+    results->bits = protocol->bits;
+    results->decode_type = protocol->decode_type;
+    return true;
+}
+
 const char* IR_getProtocolString(ir_decode_results *results) {
     switch (results->decode_type) {
     default:
@@ -445,10 +1224,10 @@ void IR_printIRResultRaw(ir_decode_results *results) {
     DBG_PRINT("(%u bits) rawData[%u]:", results->bits, count);
     for (int i = 0; i < count; i++) {
         if (i & 1) {
-            DBG_PRINT("%u", results->rawbuf[i] * MICROS_PER_TICK);
+            DBG_PRINT("%u", IR_RAW(results, i) * MICROS_PER_TICK);
         } else {
             DBG_PRINT("-");
-            DBG_PRINT("%u", (unsigned long)results->rawbuf[i] * MICROS_PER_TICK);
+            DBG_PRINT("%u", (unsigned long)IR_RAW(results, i) * MICROS_PER_TICK);
         }
         DBG_PRINT(" ");
     }
@@ -463,7 +1242,7 @@ void IR_printIRResultRawFormatted(ir_decode_results *results) {
     DBG_PRINT("rawData[%u]:\r\n", results->rawlen - 1);
 
     for (unsigned int i = 1; i < results->rawlen; i++) {
-        unsigned long x = results->rawbuf[i] * MICROS_PER_TICK;
+        unsigned long x = IR_RAW(results, i) * MICROS_PER_TICK;
         if (!(i & 1)) {  // even
             DBG_PRINT("-");
             if (x < 1000) {
@@ -503,7 +1282,7 @@ void IR_printIRResultAsCArray(ir_decode_results *results) {
 
     // Dump data
     for (unsigned int i = 1; i < results->rawlen; i++) {
-        DBG_PRINT("%u", results->rawbuf[i] * MICROS_PER_TICK);
+        DBG_PRINT("%u", IR_RAW(results, i) * MICROS_PER_TICK);
         if (i < results->rawlen - 1)
             DBG_PRINT(","); // ',' not needed on last one
         if (!(i & 1))
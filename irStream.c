@@ -0,0 +1,345 @@
+/**
+ * @file irStream.c
+ * @brief Streaming decoder for pulse distance protocols.
+ *
+ * Instead of decoding after the gap, every enabled protocol is a candidate
+ * which is advanced with each received duration. A candidate is dropped as
+ * soon as a duration does not fit, so the result is known with the last edge
+ * and the raw buffer is never scanned again.
+ * The long frame decoder does the same for one protocol without a length limit.
+ */
+
+#include "IRremote.h"
+
+#if IR_STREAM_PROTOCOLS > 0
+
+// Candidates in the order of IR_decode()
+static const ir_protocol_t * const streamProtocols[IR_STREAM_PROTOCOLS] = {
+#if DECODE_NEC
+    &IR_protocolNEC,
+#endif
+#if DECODE_PANASONIC
+    &IR_protocolPanasonic,
+#endif
+#if DECODE_LG
+    &IR_protocolLG,
+#endif
+#if DECODE_JVC
+    &IR_protocolJVC,
+#endif
+#if DECODE_SAMSUNG
+    &IR_protocolSAMSUNG,
+#endif
+#if DECODE_DENON
+    &IR_protocolDenon,
+#endif
+};
+
+#define ALL_CANDIDATES  ((uint16_t)((1UL << IR_STREAM_PROTOCOLS) - 1))
+
+void IR_streamReset(ir_stream_decoder *decoder) {
+    decoder->index = 0;
+    decoder->live = ALL_CANDIDATES & ~decoder->disabled;
+    decoder->repeat = 0;
+    memset(decoder->data, 0, sizeof(decoder->data));
+    memset(decoder->address, 0, sizeof(decoder->address));
+}
+
+// Candidates of the protocols outside of protocols
+uint16_t IR_streamDisabled(ir_protocol_mask_t protocols) {
+    uint16_t disabled = 0;
+
+    for (uint8_t candidate = 0; candidate < IR_STREAM_PROTOCOLS; candidate++) {
+        if (!(protocols & IR_PROTOCOL_BIT(streamProtocols[candidate]->decode_type))) {
+            disabled |= 1 << candidate;
+        }
+    }
+    return disabled;
+}
+
+void IR_streamSetProtocols(ir_stream_decoder *decoder, ir_protocol_mask_t protocols) {
+    decoder->disabled = IR_streamDisabled(protocols);
+}
+
+// Results of matchCandidate() besides the value of a data bit
+#define MISMATCH    (-1)
+#define NO_DATA     2
+
+//+=============================================================================
+// Match one duration against a candidate.
+// position is the index of the duration after the gap, i.e. 0 is the first mark.
+// The repeat space sets the bit mask of the candidate in *repeat.
+// Returns MISMATCH if the candidate is ruled out, NO_DATA for a header or a mark,
+// or the value of the data bit whose number is stored in *bit.
+//
+static int8_t matchCandidate(const ir_protocol_t *protocol, uint16_t *repeat, uint16_t mask, uint16_t position, uint16_t ticks, uint16_t *bit) {
+    if (protocol->headerMark.high) {
+        if (position == 0) {
+            return IR_matchTicks(ticks, &protocol->headerMark) ? NO_DATA : MISMATCH;
+        }
+        if (position == 1) {
+            if (IR_matchTicks(ticks, &protocol->headerSpace)) {
+                return NO_DATA;
+            }
+            if (protocol->repeatSpace.high && IR_matchTicks(ticks, &protocol->repeatSpace)) {
+                *repeat |= mask;
+                return NO_DATA;
+            }
+            return MISMATCH;
+        }
+        position -= 2;
+    }
+
+    if (*repeat & mask) {
+        // Repeat frame is header mark, repeat space and one bit mark
+        return position == 0 && IR_matchTicks(ticks, &protocol->bitMark) ? NO_DATA : MISMATCH;
+    }
+
+    *bit = position / 2;
+    if (*bit >= protocol->bits) {
+        // Only the stop bit may follow the data
+        return (protocol->flags & IR_PROTOCOL_STOP_BIT) && position == 2 * protocol->bits
+                && IR_matchTicks(ticks, &protocol->bitMark) ? NO_DATA : MISMATCH;
+    }
+
+    if (!(position & 1)) {
+        // Check for constant length mark
+        return IR_matchTicks(ticks, &protocol->bitMark) ? NO_DATA : MISMATCH;
+    }
+
+    // Check for variable length space indicating a 0 or 1
+    if (IR_matchTicks(ticks, &protocol->oneSpace)) {
+        return 1;
+    }
+    if (IR_matchTicks(ticks, &protocol->zeroSpace)) {
+        return 0;
+    }
+    return MISMATCH;
+}
+
+// Advance one candidate by one duration and collect its bit.
+// Returns false if the candidate is ruled out.
+static bool feedCandidate(ir_stream_decoder *decoder, uint8_t candidate, uint16_t position, uint16_t ticks) {
+    const ir_protocol_t *protocol = streamProtocols[candidate];
+    uint16_t bit;
+    int8_t match = matchCandidate(protocol, &decoder->repeat, 1 << candidate, position, ticks, &bit);
+
+    if (match == MISMATCH || match == NO_DATA) {
+        return match == NO_DATA;
+    }
+
+    uint32_t value = match;
+    if (bit < protocol->addressBits) {
+        if (protocol->flags & IR_PROTOCOL_MSB_FIRST) {
+            decoder->address[candidate] = (decoder->address[candidate] << 1) | value;
+        } else {
+            decoder->address[candidate] |= value << bit;
+        }
+    } else {
+        if (protocol->flags & IR_PROTOCOL_MSB_FIRST) {
+            decoder->data[candidate] = (decoder->data[candidate] << 1) | value;
+        } else {
+            decoder->data[candidate] |= value << (bit - protocol->addressBits);
+        }
+    }
+    return true;
+}
+
+bool IR_streamFeed(ir_stream_decoder *decoder, uint16_t ticks) {
+    uint16_t index = decoder->index++;
+
+    if (index == 0) {
+        return decoder->live != 0; // the gap carries no information
+    }
+
+    for (uint8_t candidate = 0; candidate < IR_STREAM_PROTOCOLS; candidate++) {
+        if ((decoder->live & (1 << candidate)) && !feedCandidate(decoder, candidate, index - 1, ticks)) {
+            decoder->live &= ~(1 << candidate);
+        }
+    }
+    return decoder->live != 0;
+}
+
+bool IR_streamResult(ir_stream_decoder *decoder, ir_decode_results *results) {
+    for (uint8_t candidate = 0; candidate < IR_STREAM_PROTOCOLS; candidate++) {
+        uint16_t mask = 1 << candidate;
+        if (!(decoder->live & mask)) {
+            continue;
+        }
+        const ir_protocol_t *protocol = streamProtocols[candidate];
+
+        if (decoder->repeat & mask) {
+            if (decoder->index != 4) {
+                continue;
+            }
+            results->bits = 0;
+            results->value = REPEAT;
+            results->isRepeat = true;
+        } else {
+            if (decoder->index != IR_protocolLength(protocol)) {
+                continue;
+            }
+            results->bits = protocol->bits;
+            results->value = decoder->data[candidate];
+            results->address = decoder->address[candidate];
+        }
+        results->decode_type = protocol->decode_type;
+        return true;
+    }
+    return false;
+}
+
+#ifdef USE_IR_EARLY_FRAME_END
+//+=============================================================================
+// End of frame predictor, run by the ISR.
+// The candidates follow every duration like in the streaming decoder, but no
+// bits are collected. A frame is complete once a candidate has matched all of
+// it up to its stop mark. If a live candidate could still be longer, or a
+// decoder the candidates do not cover takes longer frames with this first mark,
+// the frame is ambiguous and the gap decides as usual.
+//
+void IR_streamTrack(struct irframeend_struct *tracker, uint16_t index, uint16_t ticks) {
+    uint16_t bit;
+
+    if (index == 0) {
+        // the gap carries no information
+        tracker->live = ALL_CANDIDATES & ~tracker->disabled;
+        tracker->repeat = 0;
+        return;
+    }
+    if (index == 1) {
+        tracker->firstMark = ticks;
+    }
+    for (uint8_t candidate = 0; (tracker->live >> candidate) != 0; candidate++) {
+        uint16_t mask = 1 << candidate;
+        if ((tracker->live & mask)
+                && matchCandidate(streamProtocols[candidate], &tracker->repeat, mask, index - 1, ticks, &bit) == MISMATCH) {
+            tracker->live &= ~mask;
+        }
+    }
+}
+
+bool IR_streamFrameComplete(const struct irframeend_struct *tracker, uint16_t tracked, uint16_t length, uint16_t lastMark) {
+    bool complete = false;
+
+    for (uint8_t candidate = 0; (tracker->live >> candidate) != 0; candidate++) {
+        uint16_t mask = 1 << candidate;
+        const ir_protocol_t *protocol = streamProtocols[candidate];
+        uint16_t candidateLength;
+
+        if (!(tracker->live & mask)) {
+            continue;
+        }
+        if (tracker->repeat & mask) {
+            candidateLength = 4;
+        } else if (protocol->flags & IR_PROTOCOL_STOP_BIT) {
+            candidateLength = IR_protocolLength(protocol);
+        } else {
+            return false; // the last space is only known with the gap
+        }
+
+        if (length < candidateLength) {
+            return false;
+        }
+        // The glitch filter may still hold the last mark back from IR_streamTrack()
+        if (length == candidateLength && (tracked == length || IR_matchTicks(lastMark, &protocol->bitMark))) {
+            complete = true;
+        }
+    }
+    return complete && !IR_frameMayGrow(tracker->disabledProtocols, tracker->firstMark, length);
+}
+#endif // USE_IR_EARLY_FRAME_END
+
+#endif // IR_STREAM_PROTOCOLS > 0
+
+#ifdef USE_IR_LONG_FRAMES
+//+=============================================================================
+// Long frame decoder.
+// Same steps as a stream candidate, but the bits go straight into the buffer
+// of the caller, one byte is cleared when its first bit arrives.
+//
+void IR_longFrameReset(ir_long_frame_decoder *decoder) {
+    decoder->index = 0;
+    decoder->bits = 0;
+    decoder->live = decoder->protocol != NULL;
+}
+
+static bool feedLongFrame(ir_long_frame_decoder *decoder, uint16_t position, uint16_t ticks) {
+    const ir_protocol_t *protocol = decoder->protocol;
+
+    if (protocol->flags & IR_PROTOCOL_LEAD_IN) {
+        if (position < 2) {
+            return IR_matchTicks(ticks, position == 0 ? &protocol->bitMark : &protocol->zeroSpace);
+        }
+        position -= 2;
+    }
+    if (protocol->headerMark.high) {
+        if (position < 2) {
+            return IR_matchTicks(ticks, position == 0 ? &protocol->headerMark : &protocol->headerSpace);
+        }
+        position -= 2;
+    }
+
+    if (!(position & 1)) {
+        // Mark of a bit, or the stop mark
+        return IR_matchTicks(ticks, &protocol->bitMark);
+    }
+
+    bool one;
+    if (IR_matchTicks(ticks, &protocol->oneSpace)) {
+        one = true;
+    } else if (IR_matchTicks(ticks, &protocol->zeroSpace)) {
+        one = false;
+    } else {
+        return false;
+    }
+
+    uint16_t bit = decoder->bits;
+    if (bit >= 8 * decoder->size) {
+        return false; // does not fit the buffer
+    }
+    uint8_t *byte = &decoder->buffer[bit / 8];
+    if ((bit & 7) == 0) {
+        *byte = 0;
+    }
+    if (one) {
+        *byte |= (protocol->flags & IR_PROTOCOL_MSB_FIRST) ? 0x80 >> (bit & 7) : 1 << (bit & 7);
+    }
+    decoder->bits++;
+    return true;
+}
+
+bool IR_longFrameFeed(ir_long_frame_decoder *decoder, uint16_t ticks) {
+    uint16_t index = decoder->index++;
+
+    if (decoder->live && index > 0) { // the gap carries no information
+        decoder->live = feedLongFrame(decoder, index - 1, ticks);
+    }
+    return decoder->live;
+}
+
+bool IR_longFrameComplete(const ir_long_frame_decoder *decoder) {
+    const ir_protocol_t *protocol = decoder->protocol;
+
+    if (!decoder->live || decoder->bits < protocol->bits) {
+        return false;
+    }
+    // The frame has to end with the stop mark after the last bit
+    return decoder->index == IR_protocolLength(protocol) + 2 * (decoder->bits - protocol->bits);
+}
+
+bool IR_longFrameResult(ir_long_frame_decoder *decoder, ir_decode_results *results) {
+    const ir_protocol_t *protocol = decoder->protocol;
+
+    if (!IR_longFrameComplete(decoder)) {
+        return false;
+    }
+    results->decode_type = protocol->decode_type;
+    results->bits = decoder->bits;
+    results->value = 0;
+    results->address = 0;
+    results->isRepeat = false;
+    results->data = decoder->buffer;
+    return true;
+}
+#endif // USE_IR_LONG_FRAMES
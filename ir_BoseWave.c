@@ -112,24 +112,24 @@ bool IR_decodeBoseWave(ir_decode_results *results) {
     DBG_PRINT("Decoding Bose Wave ...\r\n");
 
     // Check we have enough data
-    if (irparams.rawlen < (2 * BOSEWAVE_BITS * 2) + 3) {
+    if (results->rawlen < (2 * BOSEWAVE_BITS * 2) + 3) {
         DBG_PRINT("\tInvalid data length found: %u\r\n", results->rawlen);
         return false;
     }
 
     // Check header "mark"
     index = 1;
-    if (!MATCH_MARK(results->rawbuf[index], BOSEWAVE_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, index), BOSEWAVE_HEADER_MARK)) {
         DBG_PRINT("\tInvalid Header Mark.  Expecting %u. Got %u\r\n",
-            BOSEWAVE_HEADER_MARK, results->rawbuf[index] * MICROS_PER_TICK);
+            BOSEWAVE_HEADER_MARK, IR_RAW(results, index) * MICROS_PER_TICK);
         return false;
     }
     index++;
 
     // Check header "space"
-    if (!MATCH_SPACE(results->rawbuf[index], BOSEWAVE_HEADER_SPACE)) {
+    if (!MATCH_SPACE(IR_RAW(results, index), BOSEWAVE_HEADER_SPACE)) {
         DBG_PRINT("\tInvalid Header Space. Expecting %u. Got %u\r\n",
-            BOSEWAVE_HEADER_SPACE, results->rawbuf[index] * MICROS_PER_TICK);
+            BOSEWAVE_HEADER_SPACE, IR_RAW(results, index) * MICROS_PER_TICK);
         return false;
     }
     index++;
@@ -137,21 +137,21 @@ bool IR_decodeBoseWave(ir_decode_results *results) {
     // Decode the data bits
     for (int ii = 7; ii >= 0; ii--) {
         // Check bit "mark".  Mark is always the same length.
-        if (!MATCH_MARK(results->rawbuf[index], BOSEWAVE_BIT_MARK)) {
+        if (!MATCH_MARK(IR_RAW(results, index), BOSEWAVE_BIT_MARK)) {
             DBG_PRINT("\tInvalid command Mark. Expecting %u. Got %u\r\n",
-                BOSEWAVE_BIT_MARK, results->rawbuf[index] * MICROS_PER_TICK);
+                BOSEWAVE_BIT_MARK, IR_RAW(results, index) * MICROS_PER_TICK);
             return false;
         }
         index++;
 
         // Check bit "space"
-        if (MATCH_SPACE(results->rawbuf[index], BOSEWAVE_ONE_SPACE)) {
+        if (MATCH_SPACE(IR_RAW(results, index), BOSEWAVE_ONE_SPACE)) {
             command |= (0x01 << ii);
-        } else if (MATCH_SPACE(results->rawbuf[index], BOSEWAVE_ZERO_SPACE)) {
+        } else if (MATCH_SPACE(IR_RAW(results, index), BOSEWAVE_ZERO_SPACE)) {
             // Nothing to do for zeroes.
         } else {
             DBG_PRINT("\tInvalid command Space. Got %u\r\n",
-                results->rawbuf[index] * MICROS_PER_TICK);
+                IR_RAW(results, index) * MICROS_PER_TICK);
             return false;
         }
         index++;
@@ -161,21 +161,21 @@ bool IR_decodeBoseWave(ir_decode_results *results) {
     // of the complement (0=1 and 1=0) so we can easily compare it to the command.
     for (int ii = 7; ii >= 0; ii--) {
         // Check bit "mark".  Mark is always the same length.
-        if (!MATCH_MARK(results->rawbuf[index], BOSEWAVE_BIT_MARK)) {
+        if (!MATCH_MARK(IR_RAW(results, index), BOSEWAVE_BIT_MARK)) {
             DBG_PRINT("\tInvalid complement Mark. Expecting %u. Got %u\r\n",
-                BOSEWAVE_BIT_MARK, results->rawbuf[index] * MICROS_PER_TICK);
+                BOSEWAVE_BIT_MARK, IR_RAW(results, index) * MICROS_PER_TICK);
             return false;
         }
         index++;
 
         // Check bit "space"
-        if (MATCH_SPACE(results->rawbuf[index], BOSEWAVE_ONE_SPACE)) {
+        if (MATCH_SPACE(IR_RAW(results, index), BOSEWAVE_ONE_SPACE)) {
             // Nothing to do.
-        } else if (MATCH_SPACE(results->rawbuf[index], BOSEWAVE_ZERO_SPACE)) {
+        } else if (MATCH_SPACE(IR_RAW(results, index), BOSEWAVE_ZERO_SPACE)) {
             complement |= (0x01 << ii);
         } else {
             DBG_PRINT("\tInvalid complement Space. Got %u\r\n",
-                results->rawbuf[index] * MICROS_PER_TICK);
+                IR_RAW(results, index) * MICROS_PER_TICK);
             return false;
         }
         index++;
@@ -190,9 +190,9 @@ bool IR_decodeBoseWave(ir_decode_results *results) {
     }
 
     // Check end "mark"
-    if (MATCH_MARK(results->rawbuf[index], BOSEWAVE_END_MARK) == 0) {
+    if (MATCH_MARK(IR_RAW(results, index), BOSEWAVE_END_MARK) == 0) {
         DBG_PRINT("\tInvalid end Mark.  Got %u\r\n",
-            results->rawbuf[index] * MICROS_PER_TICK);
+            IR_RAW(results, index) * MICROS_PER_TICK);
         return false;
     }
 
@@ -51,34 +51,33 @@ void sendDenon(unsigned long data, int nbits) {
 //+=============================================================================
 //
 #if DECODE_DENON
-bool IR_decodeDenon(ir_decode_results *results) {
-    int offset = 1;  // Skip the gap reading
-
-    // Check we have the right amount of data
-    if (irparams.rawlen != 1 + 2 + (2 * DENON_BITS) + 1) {
-        return false;
-    }
-
-    // Check initial Mark+Space match
-    if (!MATCH_MARK(results->rawbuf[offset], DENON_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-    if (!MATCH_SPACE(results->rawbuf[offset], DENON_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    // Read the bits in
-    if (!IR_decodePulseDistanceData(results, DENON_BITS, offset, DENON_BIT_MARK,
-        DENON_ONE_SPACE, DENON_ZERO_SPACE, true)) {
-        return false;
-    }
+const ir_protocol_t IR_protocolDenon = {
+    .decode_type = DENON,
+    .headerMark = IR_MARK_TICKS(DENON_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(DENON_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(DENON_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(DENON_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(DENON_ZERO_SPACE),
+    .bits = DENON_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT | IR_PROTOCOL_EXACT_LENGTH,
+};
+#endif
 
-    // Success
-    results->bits = DENON_BITS;
-    results->decode_type = DENON;
-    return true;
+//+=============================================================================
+//
+#if DECODE_DENON
+bool IR_decodeDenon(ir_decode_results *results) {
+    return IR_decodeProtocol(results, &IR_protocolDenon);
 }
+
+const ir_decoder_t IR_decoderDenon = {
+    .decode = IR_decodeDenon,
+    .decode_type = DENON,
+    .signatures = {
+        IR_SIGNATURE(DENON_HEADER_MARK, 1 + 2 + (2 * DENON_BITS) + 1, 1 + 2 + (2 * DENON_BITS) + 1),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
@@ -50,51 +50,32 @@ void sendJVC(unsigned long data, int nbits, bool repeat) {
 
 //+=============================================================================
 #if DECODE_JVC
-bool IR_decodeJVC(ir_decode_results *results) {
-    int offset = 1; // Skip first space
-
-    // Check for repeat
-    if ((results->rawlen - 1 == 33) && MATCH_MARK(results->rawbuf[offset], JVC_BIT_MARK)
-            && MATCH_MARK(results->rawbuf[results->rawlen - 1], JVC_BIT_MARK)) {
-        results->bits = 0;
-        results->value = REPEAT;
-        results->isRepeat = true;
-        results->decode_type = JVC;
-        return true;
-    }
-
-    // Initial mark
-    if (!MATCH_MARK(results->rawbuf[offset], JVC_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-    // Check we have enough data - +3 for start bit mark and space + stop bit mark
-    if (results->rawlen <= (2 * JVC_BITS) + 3) {
-        return false;
-    }
-
-    // Initial space
-    if (!MATCH_SPACE(results->rawbuf[offset], JVC_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    if (!IR_decodePulseDistanceData(results, JVC_BITS, offset, JVC_BIT_MARK,
-        JVC_ONE_SPACE, JVC_ZERO_SPACE, true)) {
-        return false;
-    }
-
-    // Stop bit
-    if (!MATCH_MARK(results->rawbuf[offset + (2 * JVC_BITS)], JVC_BIT_MARK)) {
-        DBG_PRINT("Stop bit verify failed\r\n");
-        return false;
-    }
-
-    // Success
-    results->bits = JVC_BITS;
-    results->decode_type = JVC;
+const ir_protocol_t IR_protocolJVC = {
+    .decode_type = JVC,
+    .headerMark = IR_MARK_TICKS(JVC_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(JVC_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(JVC_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(JVC_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(JVC_ZERO_SPACE),
+    .bits = JVC_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT | IR_PROTOCOL_HEADERLESS_REPEAT, // JVC repeats by skipping the header
+};
+#endif
 
-    return true;
+//+=============================================================================
+#if DECODE_JVC
+bool IR_decodeJVC(ir_decode_results *results) {
+    return IR_decodeProtocol(results, &IR_protocolJVC);
 }
+
+const ir_decoder_t IR_decoderJVC = {
+    .decode = IR_decodeJVC,
+    .decode_type = JVC,
+    .signatures = {
+        IR_SIGNATURE(JVC_BIT_MARK, 34, 34),                                 // Repeat without header
+        IR_SIGNATURE(JVC_HEADER_MARK, (2 * JVC_BITS) + 4, IR_ANY_LENGTH),
+    },
+};
 #endif
\ No newline at end of file
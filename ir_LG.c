@@ -18,39 +18,34 @@
 
 //+=============================================================================
 #if DECODE_LG
-bool IR_decodeLG(ir_decode_results *results) {
-    int offset = 1; // Skip first space
-
-    // Check we have the right amount of data  +3 for start bit mark and space + stop bit mark
-    if (irparams.rawlen <= (2 * LG_BITS) + 3)
-        return false;
-
-    // Initial mark/space
-    if (!MATCH_MARK(results->rawbuf[offset], LG_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-    if (!MATCH_SPACE(results->rawbuf[offset], LG_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    if (!IR_decodePulseDistanceData(results, LG_BITS, offset, LG_BIT_MARK,
-        LG_ONE_SPACE, LG_ZERO_SPACE, true)) {
-        return false;
-    }
-    // Stop bit
-    if (!MATCH_MARK(results->rawbuf[offset + (2 * LG_BITS)], LG_BIT_MARK)) {
-        DBG_PRINT("Stop bit verify failed\r\n");
-        return false;
-    }
+const ir_protocol_t IR_protocolLG = {
+    .decode_type = LG,
+    .headerMark = IR_MARK_TICKS(LG_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(LG_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(LG_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(LG_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(LG_ZERO_SPACE),
+    .bits = LG_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT,
+};
+#endif
 
-    // Success
-    results->bits = LG_BITS;
-    results->decode_type = LG;
-    return true;
+//+=============================================================================
+#if DECODE_LG
+bool IR_decodeLG(ir_decode_results *results) {
+    return IR_decodeProtocol(results, &IR_protocolLG);
 }
+
+const ir_decoder_t IR_decoderLG = {
+    .decode = IR_decodeLG,
+    .decode_type = LG,
+    .signatures = {
+        IR_SIGNATURE(LG_HEADER_MARK, (2 * LG_BITS) + 4, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
 
 //+=============================================================================
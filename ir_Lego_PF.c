@@ -60,19 +60,19 @@ bool IR_decodeLegoPowerFunctions(ir_decode_results *results) {
     unsigned long data = 0;  // Somewhere to build our code
     DBG_PRINT("%u\r\n", results->rawlen);
     // Check we have the right amount of data
-    if (irparams.rawlen != (2 * LEGO_PF_BITS) + 4)
+    if (results->rawlen != (2 * LEGO_PF_BITS) + 4)
         return false;
 
     DBG_PRINT("Attempting Lego Power Functions Decode\r\n");
 
-    uint16_t desired_us = (results->rawbuf[1] + results->rawbuf[2]) * MICROS_PER_TICK;
+    uint16_t desired_us = (IR_RAW(results, 1) + IR_RAW(results, 2)) * MICROS_PER_TICK;
     DBG_PRINT("PF desired_us = %u\r\n", desired_us);
 
     if (desired_us > LEGO_PF_HIBIT && desired_us <= LEGO_PF_STARTSTOP) {
         DBG_PRINT("Found PF Start Bit\r\n");
         int offset = 3;
         for (int i = 0; i < LEGO_PF_BITS; i++) {
-            desired_us = (results->rawbuf[offset] + results->rawbuf[offset + 1]) * MICROS_PER_TICK;
+            desired_us = (IR_RAW(results, offset) + IR_RAW(results, offset + 1)) * MICROS_PER_TICK;
 
             DBG_PRINT("PF desired_us = %u\r\n", desired_us);
             if (desired_us >= LEGO_PF_LOWER && desired_us <= LEGO_PF_LOWBIT) {
@@ -88,7 +88,7 @@ bool IR_decodeLegoPowerFunctions(ir_decode_results *results) {
             offset += 2;
         }
 
-        desired_us = (results->rawbuf[offset]) * MICROS_PER_TICK;
+        desired_us = (IR_RAW(results, offset)) * MICROS_PER_TICK;
 
         DBG_PRINT("PF END desired_us = %u\r\n", desired_us);
         if (desired_us < LEGO_PF_LOWER) {
@@ -103,4 +103,13 @@ bool IR_decodeLegoPowerFunctions(ir_decode_results *results) {
     }
     return false;
 }
+
+const ir_decoder_t IR_decoderLegoPowerFunctions = {
+    .decode = IR_decodeLegoPowerFunctions,
+    .decode_type = LEGO_PF,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK((2 * LEGO_PF_BITS) + 4, (2 * LEGO_PF_BITS) + 4), // Start bit is mark + space
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
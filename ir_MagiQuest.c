@@ -91,15 +91,15 @@ bool IR_decodeMagiQuest(ir_decode_results *results) {
     // Check we have enough data
     if (results->rawlen < 2 * MAGIQUEST_BITS) {
         DBG_PRINT("Not enough bits to be a MagiQuest packet (%u < %u)\r\n", 
-            irparams.rawlen, MAGIQUEST_BITS*2);
+            results->rawlen, MAGIQUEST_BITS*2);
         return false;
     }
 
     // Read the bits in
     data.llword = 0;
     while (offset + 1 < results->rawlen) {
-        mark_ = results->rawbuf[offset++];
-        space_ = results->rawbuf[offset++];
+        mark_ = IR_RAW(results, offset++);
+        space_ = IR_RAW(results, offset++);
         ratio_ = space_ / mark_;
 
         DBG_PRINT("mark=%u space=%u ratio=%u\r\n",
@@ -139,4 +139,13 @@ bool IR_decodeMagiQuest(ir_decode_results *results) {
 
     return true;
 }
+
+const ir_decoder_t IR_decoderMagiQuest = {
+    .decode = IR_decodeMagiQuest,
+    .decode_type = MAGIQUEST,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK(2 * MAGIQUEST_BITS, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
@@ -103,57 +103,53 @@ void sendNECStandard(uint16_t aAddress, uint8_t aCommand, uint8_t aNumberOfRepea
     }
 }
 #endif
+//+=============================================================================
+#if DECODE_NEC
+const ir_protocol_t IR_protocolNEC = {
+    .decode_type = NEC,
+    .headerMark = IR_MARK_TICKS(NEC_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(NEC_HEADER_SPACE),
+    .repeatSpace = IR_SPACE_TICKS(NEC_REPEAT_SPACE),
+    .bitMark = IR_MARK_TICKS(NEC_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(NEC_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(NEC_ZERO_SPACE),
+    .bits = NEC_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT,
+};
+#endif
+
+#if DECODE_NEC_STANDARD
+const ir_protocol_t IR_protocolNECStandard = {
+    .decode_type = NEC_STANDARD,
+    .headerMark = IR_MARK_TICKS(NEC_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(NEC_HEADER_SPACE),
+    .repeatSpace = IR_SPACE_TICKS(NEC_REPEAT_SPACE),
+    .bitMark = IR_MARK_TICKS(NEC_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(NEC_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(NEC_ZERO_SPACE),
+    .bits = NEC_BITS,
+    .addressBits = 16,
+    .flags = IR_PROTOCOL_STOP_BIT | IR_PROTOCOL_INVERTED_COMMAND,
+};
+#endif
+
 //+=============================================================================
 // NECs have a repeat only 4 items long
 //
 #if DECODE_NEC
 bool IR_decodeNEC(ir_decode_results *results) {
-    int offset = 1;  // Index in to results; Skip first space.
-
-// Check header "mark"
-    if (!MATCH_MARK(results->rawbuf[offset], NEC_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-// Check for repeat
-    if ((results->rawlen == 4) && MATCH_SPACE(results->rawbuf[offset], NEC_REPEAT_SPACE)
-            && MATCH_MARK(results->rawbuf[offset + 1], NEC_BIT_MARK)) {
-        results->bits = 0;
-        results->value = REPEAT;
-        results->isRepeat = true;
-        results->decode_type = NEC;
-        return true;
-    }
-
-// Check we have enough data - +3 for start bit mark and space + stop bit mark
-    if (results->rawlen <= (2 * NEC_BITS) + 3) {
-        return false;
-    }
-
-// Check header "space"
-    if (!MATCH_SPACE(results->rawbuf[offset], NEC_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    if (!IR_decodePulseDistanceData(results, NEC_BITS, offset, NEC_BIT_MARK,
-        NEC_ONE_SPACE, NEC_ZERO_SPACE, true)) {
-        return false;
-    }
-
-    // Stop bit
-    if (!MATCH_MARK(results->rawbuf[offset + (2 * NEC_BITS)], NEC_BIT_MARK)) {
-        DBG_PRINT("Stop bit verify failed\r\n");
-        return false;
-    }
-
-// Success
-    results->bits = NEC_BITS;
-    results->decode_type = NEC;
-
-    return true;
+    return IR_decodeProtocol(results, &IR_protocolNEC);
 }
+
+const ir_decoder_t IR_decoderNEC = {
+    .decode = IR_decodeNEC,
+    .decode_type = NEC,
+    .signatures = {
+        IR_SIGNATURE(NEC_HEADER_MARK, 4, 4),                                // Repeat
+        IR_SIGNATURE(NEC_HEADER_MARK, (2 * NEC_BITS) + 4, IR_ANY_LENGTH),
+    },
+};
 #endif
 
 //+=============================================================================
@@ -161,58 +157,16 @@ bool IR_decodeNEC(ir_decode_results *results) {
 //
 #if DECODE_NEC_STANDARD
 bool IR_decodeNECStandard(ir_decode_results *results) {
-    long data = 0;  // We decode in to here; Start with nothing
-    int offset = 1;  // Index in to results; Skip first space.
-
-    // Check header "mark"
-    if (!MATCH_MARK(results->rawbuf[offset], NEC_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-    // Check for repeat
-    if ((results->rawlen == 4) && MATCH_SPACE(results->rawbuf[offset], NEC_REPEAT_SPACE)
-            && MATCH_MARK(results->rawbuf[offset + 1], NEC_BIT_MARK)) {
-        results->isRepeat = true;
-        results->bits = 0;
-        return true;
-    }
-
-    // Check we have enough data - +3 for start bit mark and space + stop bit mark
-    if (results->rawlen <= (2 * NEC_BITS) + 3) {
-        return false;
-    }
-    // Check header "space"
-    if (!MATCH_SPACE(results->rawbuf[offset], NEC_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    data = IR_decodePulseDistanceData(NEC_BITS, offset, NEC_BIT_MARK,
-        NEC_ONE_SPACE, NEC_ZERO_SPACE, false);
-
-    // Stop bit
-    if (!MATCH_MARK(results->rawbuf[offset + (2 * NEC_BITS)], NEC_BIT_MARK)) {
-        DBG_PRINT("Stop bit verify failed\r\n");
-       return false;
-    }
-
-    // Success
-    uint16_t tCommand = data >> 16;
-    uint8_t tCommandNotInverted = tCommand & 0xFF;
-    uint8_t tCommandInverted = tCommand >> 8;
-    // plausi check for command
-    if ((tCommandNotInverted ^ tCommandInverted) != 0xFF) {
-        return false;
-    }
-
-    results->isRepeat = false;
-    results->value = tCommandNotInverted;
-    results->bits = NEC_BITS;
-    results->address = data & 0xFFFF; // first 16 bit
-    results->decode_type = NEC_STANDARD;
-
-    return true;
+    return IR_decodeProtocol(results, &IR_protocolNECStandard);
 }
+
+const ir_decoder_t IR_decoderNECStandard = {
+    .decode = IR_decodeNECStandard,
+    .decode_type = NEC_STANDARD,
+    .signatures = {
+        IR_SIGNATURE(NEC_HEADER_MARK, 4, 4),                                // Repeat
+        IR_SIGNATURE(NEC_HEADER_MARK, (2 * NEC_BITS) + 4, IR_ANY_LENGTH),
+    },
+};
 #endif
 
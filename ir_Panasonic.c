@@ -43,37 +43,32 @@ void sendPanasonic(unsigned int address, unsigned long data) {
 
 //+=============================================================================
 #if DECODE_PANASONIC
-bool IR_decodePanasonic(ir_decode_results *results) {
-    int offset = 1;
-
-    if (results->rawlen < (2 * PANASONIC_BITS) + 2) {
-        return false;
-    }
-
-    if (!MATCH_MARK(results->rawbuf[offset], PANASONIC_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-    if (!MATCH_MARK(results->rawbuf[offset], PANASONIC_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    // decode address
-    if (!IR_decodePulseDistanceData(results, PANASONIC_ADDRESS_BITS, offset, PANASONIC_BIT_MARK,
-        PANASONIC_ONE_SPACE, PANASONIC_ZERO_SPACE, true)) {
-        return false;
-    }
-    results->address = results->value;
-
-    if (!IR_decodePulseDistanceData(results, PANASONIC_DATA_BITS, offset + PANASONIC_ADDRESS_BITS,
-        PANASONIC_BIT_MARK, PANASONIC_ONE_SPACE, PANASONIC_ZERO_SPACE, true)) {
-        return false;
-    }
-
-    results->decode_type = PANASONIC;
-    results->bits = PANASONIC_BITS;
+const ir_protocol_t IR_protocolPanasonic = {
+    .decode_type = PANASONIC,
+    .headerMark = IR_MARK_TICKS(PANASONIC_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(PANASONIC_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(PANASONIC_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(PANASONIC_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(PANASONIC_ZERO_SPACE),
+    .bits = PANASONIC_BITS,
+    .addressBits = PANASONIC_ADDRESS_BITS,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT,
+};
+#endif
 
-    return true;
+//+=============================================================================
+#if DECODE_PANASONIC
+bool IR_decodePanasonic(ir_decode_results *results) {
+    return IR_decodeProtocol(results, &IR_protocolPanasonic);
 }
+
+const ir_decoder_t IR_decoderPanasonic = {
+    .decode = IR_decodePanasonic,
+    .decode_type = PANASONIC,
+    .signatures = {
+        IR_SIGNATURE(PANASONIC_HEADER_MARK, (2 * PANASONIC_BITS) + 4, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
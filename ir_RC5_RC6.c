@@ -19,7 +19,7 @@ int getRClevel(ir_decode_results *results, unsigned int *offset, int *used, int
     if (*offset >= results->rawlen) {
         return SPACE;  // After end of recorded buffer, assume SPACE.
     }
-    width = results->rawbuf[*offset];
+    width = IR_RAW(results, *offset);
     val = ((*offset) % 2) ? MARK : SPACE;
     correction = (val == MARK) ? MARK_EXCESS_MICROS : - MARK_EXCESS_MICROS;
 
@@ -195,6 +195,15 @@ bool IR_decodeRC5(ir_decode_results *results) {
     results->decode_type = RC5;
     return true;
 }
+
+const ir_decoder_t IR_decoderRC5 = {
+    .decode = IR_decodeRC5,
+    .decode_type = RC5,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK(MIN_RC5_SAMPLES + 2, IR_ANY_LENGTH),  // First mark is one or two T1
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
 
 //+=============================================================================
@@ -256,12 +265,12 @@ bool IR_decodeRC6(ir_decode_results *results) {
     }
 
     // Initial mark
-    if (!MATCH_MARK(results->rawbuf[offset], RC6_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, offset), RC6_HEADER_MARK)) {
         return false;
     }
     offset++;
 
-    if (!MATCH_SPACE(results->rawbuf[offset], RC6_HEADER_SPACE)) {
+    if (!MATCH_SPACE(IR_RAW(results, offset), RC6_HEADER_SPACE)) {
         return false;
     }
     offset++;
@@ -308,4 +317,13 @@ bool IR_decodeRC6(ir_decode_results *results) {
     results->decode_type = RC6;
     return true;
 }
+
+const ir_decoder_t IR_decoderRC6 = {
+    .decode = IR_decodeRC6,
+    .decode_type = RC6,
+    .signatures = {
+        IR_SIGNATURE(RC6_HEADER_MARK, MIN_RC6_SAMPLES, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
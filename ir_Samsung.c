@@ -36,46 +36,36 @@ void sendSAMSUNG(unsigned long data, int nbits) {
 }
 #endif
 
+//+=============================================================================
+#if DECODE_SAMSUNG
+const ir_protocol_t IR_protocolSAMSUNG = {
+    .decode_type = SAMSUNG,
+    .headerMark = IR_MARK_TICKS(SAMSUNG_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(SAMSUNG_HEADER_SPACE),
+    .repeatSpace = IR_SPACE_TICKS(SAMSUNG_REPEAT_SPACE),
+    .bitMark = IR_MARK_TICKS(SAMSUNG_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(SAMSUNG_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(SAMSUNG_ZERO_SPACE),
+    .bits = SAMSUNG_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT,
+};
+#endif
+
 //+=============================================================================
 // SAMSUNGs have a repeat only 4 items long
 //
 #if DECODE_SAMSUNG
 bool IR_decodeSAMSUNG(ir_decode_results *results) {
-    int offset = 1;  // Skip first space
-
-    // Initial mark
-    if (!MATCH_MARK(results->rawbuf[offset], SAMSUNG_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
-
-// Check for repeat
-    if ((irparams.rawlen == 4) && MATCH_SPACE(results->rawbuf[offset], SAMSUNG_REPEAT_SPACE)
-            && MATCH_MARK(results->rawbuf[offset + 1], SAMSUNG_BIT_MARK)) {
-        results->bits = 0;
-        results->value = REPEAT;
-        results->isRepeat = true;
-        results->decode_type = SAMSUNG;
-        return true;
-    }
-    if (irparams.rawlen < (2 * SAMSUNG_BITS) + 4) {
-        return false;
-    }
-
-// Initial space
-    if (!MATCH_SPACE(results->rawbuf[offset], SAMSUNG_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    if (!IR_decodePulseDistanceData(results, SAMSUNG_BITS, offset, SAMSUNG_BIT_MARK,
-        SAMSUNG_ONE_SPACE, SAMSUNG_ZERO_SPACE, true)) {
-        return false;
-    }
-
-// Success
-    results->bits = SAMSUNG_BITS;
-    results->decode_type = SAMSUNG;
-    return true;
+    return IR_decodeProtocol(results, &IR_protocolSAMSUNG);
 }
+
+const ir_decoder_t IR_decoderSAMSUNG = {
+    .decode = IR_decodeSAMSUNG,
+    .decode_type = SAMSUNG,
+    .signatures = {
+        IR_SIGNATURE(SAMSUNG_HEADER_MARK, 4, 4),                            // Repeat
+        IR_SIGNATURE(SAMSUNG_HEADER_MARK, (2 * SAMSUNG_BITS) + 4, IR_ANY_LENGTH),
+    },
+};
 #endif
\ No newline at end of file
@@ -31,11 +31,11 @@ bool IR_decodeSanyo(ir_decode_results *results) {
 
 #if 0
 	// Put this back in for debugging - note can't use #DEBUG as if Debug on we don't see the repeat cos of the delay
-	DBG_PRINT(("IR Gap: %u test against: %u\r\n", results->rawbuf[offset], SANYO_DOUBLE_SPACE_USECS);
+	DBG_PRINT(("IR Gap: %u test against: %u\r\n", IR_RAW(results, offset), SANYO_DOUBLE_SPACE_USECS);
 #endif
 
 // Initial space
-    if (results->rawbuf[offset] < (SANYO_DOUBLE_SPACE_USECS / MICROS_PER_TICK)) {
+    if (IR_RAW(results, offset) < (SANYO_DOUBLE_SPACE_USECS / MICROS_PER_TICK)) {
         // DBG_PRINT("IR Gap found\r\n");
         results->bits = 0;
         results->value = REPEAT;
@@ -46,26 +46,26 @@ bool IR_decodeSanyo(ir_decode_results *results) {
     offset++;
 
     // Initial mark
-    if (!MATCH_MARK(results->rawbuf[offset], SANYO_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, offset), SANYO_HEADER_MARK)) {
         return false;
     }
     offset++;
 
     // Skip Second Mark
-    if (!MATCH_MARK(results->rawbuf[offset], SANYO_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, offset), SANYO_HEADER_MARK)) {
         return false;
     }
     offset++;
 
-    while (offset + 1 < irparams.rawlen) {
-        if (!MATCH_SPACE(results->rawbuf[offset], SANYO_HEADER_SPACE)) {
+    while (offset + 1 < results->rawlen) {
+        if (!MATCH_SPACE(IR_RAW(results, offset), SANYO_HEADER_SPACE)) {
             break;
         }
         offset++;
 
-        if (MATCH_MARK(results->rawbuf[offset], SANYO_ONE_MARK)) {
+        if (MATCH_MARK(IR_RAW(results, offset), SANYO_ONE_MARK)) {
             data = (data << 1) | 1;
-        } else if (MATCH_MARK(results->rawbuf[offset], SANYO_ZERO_MARK)) {
+        } else if (MATCH_MARK(IR_RAW(results, offset), SANYO_ZERO_MARK)) {
             data = (data << 1) | 0;
         } else {
             return false;
@@ -84,4 +84,13 @@ bool IR_decodeSanyo(ir_decode_results *results) {
     results->decode_type = SANYO;
     return true;
 }
+
+const ir_decoder_t IR_decoderSanyo = {
+    .decode = IR_decodeSanyo,
+    .decode_type = SANYO,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK((2 * SANYO_BITS) + 2, IR_ANY_LENGTH), // Repeats are detected by the gap
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
@@ -102,18 +102,18 @@ bool IR_decodeSharp(ir_decode_results *results) {
     // Check we have the right amount of data
     // Either one burst or three where second is inverted
     // The setting #define _GAP 5000 in IRremoteInt.h will give one burst and possibly three calls to this function
-    if (irparams.rawlen == (SHARP_BITS + 1) * 2)
+    if (results->rawlen == (SHARP_BITS + 1) * 2)
         loops = 1;
-    else if (irparams.rawlen == (SHARP_BITS + 1) * 2 * 3)
+    else if (results->rawlen == (SHARP_BITS + 1) * 2 * 3)
         loops = 3;
     else
         return false;
 
     // Check the first mark to see if it fits the SHARP_BIT_MARK_RECV length
-    if (!MATCH_MARK(results->rawbuf[offset], SHARP_BIT_MARK_RECV))
+    if (!MATCH_MARK(IR_RAW(results, offset), SHARP_BIT_MARK_RECV))
         return false;
     //check the first pause and see if it fits the SHARP_ONE_SPACE or SHARP_ZERO_SPACE length
-    if (!(MATCH_SPACE(results->rawbuf[offset + 1], SHARP_ONE_SPACE) || MATCH_SPACE(results->rawbuf[offset + 1], SHARP_ZERO_SPACE)))
+    if (!(MATCH_SPACE(IR_RAW(results, offset + 1), SHARP_ONE_SPACE) || MATCH_SPACE(IR_RAW(results, offset + 1), SHARP_ZERO_SPACE)))
         return false;
 
     // Read the bits in
@@ -144,4 +144,13 @@ bool IR_decodeSharp(ir_decode_results *results) {
     results->decode_type = SHARP;
     return true;
 }
+
+const ir_decoder_t IR_decoderSharp = {
+    .decode = IR_decodeSharp,
+    .decode_type = SHARP,
+    .signatures = {
+        IR_SIGNATURE(SHARP_BIT_MARK_RECV, (SHARP_BITS + 1) * 2, (SHARP_BITS + 1) * 2),      // One burst
+        IR_SIGNATURE(SHARP_BIT_MARK_RECV, (SHARP_BITS + 1) * 2 * 3, (SHARP_BITS + 1) * 2 * 3),  // Three bursts
+    },
+};
 #endif
\ No newline at end of file
@@ -67,25 +67,26 @@ void sendSharpAlt(uint8_t address, uint8_t command) {
 //+=============================================================================
 #if DECODE_SHARP_ALT
 bool IR_decodeSharpAlt(ir_decode_results *results) {
-    static bool is_first_repeat = true;
-
     // Check we have enough data.
     if (results->rawlen < (SHARP_ALT_RAWLEN))
         return false;
 
     // Check stop mark.
-    if (!MATCH_MARK(results->rawbuf[SHARP_ALT_RAWLEN - 1], SHARP_ALT_BIT_MARK))
+    if (!MATCH_MARK(IR_RAW(results, SHARP_ALT_RAWLEN - 1), SHARP_ALT_BIT_MARK))
         return false;
 
     // Check the "check bit." If this bit is not 0 than it is an inverted
     // frame, which we ignore.
-    if (!MATCH_SPACE(results->rawbuf[SHARP_ALT_RAWLEN - 2], SHARP_ALT_ZERO_SPACE))
+    if (!MATCH_SPACE(IR_RAW(results, SHARP_ALT_RAWLEN - 2), SHARP_ALT_ZERO_SPACE))
         return false;
 
     // Check for repeat.
-    long initial_space = ((long) results->rawbuf[0]) * MICROS_PER_TICK;
+    long initial_space = ((long) IR_RAW(results, 0)) * MICROS_PER_TICK;
     if (initial_space <= SHARP_ALT_REPEAT_SPACE) {
-        if (!is_first_repeat) {
+        if (!results->state) {
+            return false; // no way to tell the first repeat
+        }
+        if (results->state->sharpAltRepeatSkipped) {
             results->bits = 0;
             results->value = REPEAT;
             results->isRepeat = true;
@@ -94,7 +95,7 @@ bool IR_decodeSharpAlt(ir_decode_results *results) {
         } else {
             // Ignore the first repeat that always comes after the
             // inverted frame (even if the button was pressed only once).
-            is_first_repeat = false;
+            results->state->sharpAltRepeatSkipped = true;
             return false;
         }
     }
@@ -104,9 +105,9 @@ bool IR_decodeSharpAlt(ir_decode_results *results) {
     // expansion bit (-2).
     uint16_t bits = 0;
     for (uint8_t i = SHARP_ALT_RAWLEN - 6; i > 1; i -= 2) {
-        if (MATCH_SPACE(results->rawbuf[i], SHARP_ALT_ONE_SPACE)) {
+        if (MATCH_SPACE(IR_RAW(results, i), SHARP_ALT_ONE_SPACE)) {
             bits = (bits << 1) | 1;
-        } else if (MATCH_SPACE(results->rawbuf[i], SHARP_ALT_ZERO_SPACE)) {
+        } else if (MATCH_SPACE(IR_RAW(results, i), SHARP_ALT_ZERO_SPACE)) {
             bits = (bits << 1) | 0;
         } else {
             return false;
@@ -117,7 +118,18 @@ bool IR_decodeSharpAlt(ir_decode_results *results) {
     results->address = (bits & (1 << (SHARP_ALT_ADDRESS_BITS))) - 1;
     results->value = bits >> SHARP_ALT_ADDRESS_BITS; // command
     results->decode_type = SHARP_ALT;
-    is_first_repeat = true;
+    if (results->state) {
+        results->state->sharpAltRepeatSkipped = false;
+    }
     return true;
 }
+
+const ir_decoder_t IR_decoderSharpAlt = {
+    .decode = IR_decodeSharpAlt,
+    .decode_type = SHARP_ALT,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK(SHARP_ALT_RAWLEN, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
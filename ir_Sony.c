@@ -60,7 +60,7 @@ bool IR_decodeSony(ir_decode_results *results) {
 
     // Some Sony's deliver repeats fast after first
     // unfortunately can't spot difference from of repeat from two fast clicks
-    if (results->rawbuf[offset] < (SONY_DOUBLE_SPACE_USECS / MICROS_PER_TICK)) {
+    if (IR_RAW(results, offset) < (SONY_DOUBLE_SPACE_USECS / MICROS_PER_TICK)) {
         DBG_PRINTLN("IR Gap found");
         results->bits = 0;
         results->value = REPEAT;
@@ -71,13 +71,13 @@ bool IR_decodeSony(ir_decode_results *results) {
     offset++;
 
     // Check header "mark"
-    if (!MATCH_MARK(results->rawbuf[offset], SONY_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, offset), SONY_HEADER_MARK)) {
         return false;
     }
     offset++;
 
     // Check header "space"
-    if (!MATCH_SPACE(results->rawbuf[offset], SONY_SPACE)) {
+    if (!MATCH_SPACE(IR_RAW(results, offset), SONY_SPACE)) {
         return false;
     }
     offset++;
@@ -85,9 +85,9 @@ bool IR_decodeSony(ir_decode_results *results) {
     // MSB first - Not compatible to standard, which says LSB first :-(
     while (offset < results->rawlen) {
         // bit value is determined by length of the mark
-        if (MATCH_MARK(results->rawbuf[offset], SONY_ONE_MARK)) {
+        if (MATCH_MARK(IR_RAW(results, offset), SONY_ONE_MARK)) {
             data = (data << 1) | 1;
-        } else if (MATCH_MARK(results->rawbuf[offset], SONY_ZERO_MARK)) {
+        } else if (MATCH_MARK(IR_RAW(results, offset), SONY_ZERO_MARK)) {
             data = (data << 1) | 0;
         } else {
             return false;
@@ -95,7 +95,7 @@ bool IR_decodeSony(ir_decode_results *results) {
         offset++;
 
         // check for the constant space length
-        if (!MATCH_SPACE(results->rawbuf[offset], SONY_SPACE)) {
+        if (!MATCH_SPACE(IR_RAW(results, offset), SONY_SPACE)) {
             return false;
         }
         offset++;
@@ -106,4 +106,13 @@ bool IR_decodeSony(ir_decode_results *results) {
     results->decode_type = SONY;
     return true;
 }
+
+const ir_decoder_t IR_decoderSony = {
+    .decode = IR_decodeSony,
+    .decode_type = SONY,
+    .signatures = {
+        IR_SIGNATURE_ANY_MARK((2 * SONY_BITS) + 2, IR_ANY_LENGTH),  // Repeats are detected by the gap
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
@@ -154,12 +154,12 @@ bool IR_decodeShuzu(ir_decode_results *results) {
     }
 
     // Check initial Mark+Space match
-    if (!MATCH_MARK(results->rawbuf[offset], SHUZU_HEADER_MARK)) {
+    if (!MATCH_MARK(IR_RAW(results, offset), SHUZU_HEADER_MARK)) {
         return false;
     }
     offset++;
 
-    if (!MATCH_SPACE(results->rawbuf[offset], SHUZU_HEADER_SPACE)) {
+    if (!MATCH_SPACE(IR_RAW(results, offset), SHUZU_HEADER_SPACE)) {
         return false;
     }
     offset++;
@@ -170,15 +170,15 @@ bool IR_decodeShuzu(ir_decode_results *results) {
 //    for (int i = 0; i < SHUZU_BITS; i++) {
 //        // Each bit looks like: MARK + SPACE_1 -> 1
 //        //                 or : MARK + SPACE_0 -> 0
-//        if (!MATCH_MARK(results->rawbuf[offset], SHUZU_BIT_MARK)) {
+//        if (!MATCH_MARK(IR_RAW(results, offset), SHUZU_BIT_MARK)) {
 //            return false;
 //        }
 //        offset++;
 //
 //        // IR data is big-endian, so we shuffle it in from the right:
-//        if (MATCH_SPACE(results->rawbuf[offset], SHUZU_ONE_SPACE)) {
+//        if (MATCH_SPACE(IR_RAW(results, offset), SHUZU_ONE_SPACE)) {
 //            data = (data << 1) | 1;
-//        } else if (MATCH_SPACE(results->rawbuf[offset], SHUZU_ZERO_SPACE)) {
+//        } else if (MATCH_SPACE(IR_RAW(results, offset), SHUZU_ZERO_SPACE)) {
 //            data = (data << 1) | 0;
 //        } else {
 //            return false;
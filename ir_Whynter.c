@@ -50,50 +50,29 @@ void sendWhynter(unsigned long data, int nbits) {
 
 //+=============================================================================
 #if DECODE_WHYNTER
-bool IR_decodeWhynter(ir_decode_results *results) {
-    int offset = 1;  // skip initial space
-
-    // Check we have the right amount of data +5 for (start bit + header) mark and space + stop bit mark
-    if (results->rawlen <= (2 * WHYNTER_BITS) + 5) {
-        return false;
-    }
-
-    // Sequence begins with a bit mark and a zero space
-    if (!MATCH_MARK(results->rawbuf[offset], WHYNTER_BIT_MARK)) {
-        return false;
-    }
-    offset++;
-
-    if (!MATCH_SPACE(results->rawbuf[offset], WHYNTER_ZERO_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    // header mark and space
-    if (!MATCH_MARK(results->rawbuf[offset], WHYNTER_HEADER_MARK)) {
-        return false;
-    }
-    offset++;
+const ir_protocol_t IR_protocolWhynter = {
+    .decode_type = WHYNTER,
+    .headerMark = IR_MARK_TICKS(WHYNTER_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(WHYNTER_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(WHYNTER_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(WHYNTER_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(WHYNTER_ZERO_SPACE),
+    .bits = WHYNTER_BITS,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT | IR_PROTOCOL_LEAD_IN, // Sequence begins with a bit mark and a zero space
+};
 
-    if (!MATCH_SPACE(results->rawbuf[offset], WHYNTER_HEADER_SPACE)) {
-        return false;
-    }
-    offset++;
-
-    if (!IR_decodePulseDistanceData(results, WHYNTER_BITS, offset, WHYNTER_BIT_MARK,
-        WHYNTER_ONE_SPACE, WHYNTER_ZERO_SPACE, true)) {
-        return false;
-    }
-
-    // trailing mark / stop bit
-    if (!MATCH_MARK(results->rawbuf[offset + (2 * WHYNTER_BITS)], WHYNTER_BIT_MARK)) {
-        DBG_PRINT("Stop bit verify failed\r\n");
-        return false;
-    }
-
-    // Success
-    results->bits = WHYNTER_BITS;
-    results->decode_type = WHYNTER;
-    return true;
+bool IR_decodeWhynter(ir_decode_results *results) {
+    return IR_decodeProtocol(results, &IR_protocolWhynter);
 }
+
+const ir_decoder_t IR_decoderWhynter = {
+    .decode = IR_decodeWhynter,
+    .decode_type = WHYNTER,
+    .signatures = {
+        IR_SIGNATURE(WHYNTER_BIT_MARK, (2 * WHYNTER_BITS) + 6, IR_ANY_LENGTH),
+        IR_SIGNATURE_NONE,
+    },
+};
 #endif
\ No newline at end of file
@@ -2,12 +2,17 @@
 #include "IRremoteBoardDefs.h"
 #include "stm32l0xx_ll_tim.h"
 #include "stm32l0xx_ll_gpio.h"
+#ifdef USE_TIMER_DMA_MODE
+#include "stm32l0xx_ll_dma.h"
+#endif
 
 #define TIM_SYSCLOCK	24000000 // Hz
 
 #define TIM_PRESCALER	((TIM_SYSCLOCK) / 1000000 - 1) // 1Mhz
 
-#ifdef USE_TIMER_IC_MODE
+#if defined(USE_TIMER_DMA_MODE) || defined(USE_TIMER_IC_FREE_RUNNING)
+#define TIM_PERIOD		0xFFFF // free running, timestamps wrap after 65.5ms
+#elif defined(USE_TIMER_IC_MODE)
 #define TIM_PERIOD		(10000 - 1) // 10ms
 #else
 #define TIM_PERIOD		(50 - 1) // 50us
@@ -43,12 +48,98 @@ void IR_timerConfigForSend(uint16_t aFrequencyKHz)
 	LL_TIM_DisableMasterSlaveMode(TIMx);
 }
 
-#ifdef USE_TIMER_IC_MODE
+#if defined(USE_TIMER_DMA_MODE)
+// Timer reconfiguration for Input Capture mode with DMA transfer of the timestamps.
+// CH2 captures both edges, every capture is moved by DMA out of CCR2.
+// CH3 is a plain compare channel used for the end of frame timeout.
+static inline void timerConfigDMAForReceive(const ir_receiver_hw_t *hw)
+{
+	TIM_TypeDef *TIMx = hw->tim;
+	IRQn_Type IRQn = hw->irqn;
+
+	NVIC_DisableIRQ(IRQn);
+	LL_TIM_DeInit(TIMx);
+
+	LL_TIM_InitTypeDef TIM_InitStruct = {0};
+	LL_GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	// Configure TIM2_CH2 GPIO pin
+	GPIO_InitStruct.Pin = hw->pin;
+	GPIO_InitStruct.Mode = LL_GPIO_MODE_ALTERNATE;
+	GPIO_InitStruct.Speed = LL_GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+	GPIO_InitStruct.Pull = LL_GPIO_PULL_NO;
+	GPIO_InitStruct.Alternate = hw->af;
+	LL_GPIO_Init(hw->port, &GPIO_InitStruct);
+
+	TIM_InitStruct.Prescaler = TIM_PRESCALER;
+	TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
+	TIM_InitStruct.Autoreload = TIM_PERIOD;
+	TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
+	LL_TIM_Init(TIMx, &TIM_InitStruct);
+
+	LL_TIM_DisableARRPreload(TIMx);
+	LL_TIM_SetClockSource(TIMx, LL_TIM_CLOCKSOURCE_INTERNAL);
+	LL_TIM_SetTriggerOutput(TIMx, LL_TIM_TRGO_RESET);
+	LL_TIM_DisableMasterSlaveMode(TIMx);
+
+	LL_TIM_IC_SetActiveInput(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_ACTIVEINPUT_DIRECTTI);
+	LL_TIM_IC_SetPrescaler(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_ICPSC_DIV1);
+	LL_TIM_IC_SetFilter(TIMx, LL_TIM_CHANNEL_CH2, IR_IC_FILTER);
+	LL_TIM_IC_SetPolarity(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_IC_POLARITY_BOTHEDGE);
+	LL_TIM_OC_SetMode(TIMx, LL_TIM_CHANNEL_CH3, LL_TIM_OCMODE_FROZEN);
+
+	NVIC_EnableIRQ(IRQn);
+	// The first edge of a frame wakes up the CPU, the ISR switches over to the timeout then
+	LL_TIM_EnableIT_CC2(TIMx);
+	LL_TIM_EnableDMAReq_CC2(TIMx);
+
+	LL_TIM_CC_EnableChannel(TIMx, LL_TIM_CHANNEL_CH2);
+
+	LL_TIM_EnableCounter(TIMx);
+}
+
+// Clear all flags of the receiver DMA channel, the flags of channel x start at bit 4 * (x - 1)
+void IR_dmaClearFlags(const ir_receiver_hw_t *hw)
+{
+	WRITE_REG(hw->dma->IFCR, DMA_IFCR_CGIF1 << ((hw->dmaChannel - LL_DMA_CHANNEL_1) * 4));
+}
+
+void IR_dmaConfigForReceive(const ir_receiver_hw_t *hw, uint16_t *aTimestamps, uint16_t aLength)
+{
+	LL_DMA_InitTypeDef DMA_InitStruct = {0};
+
+	NVIC_DisableIRQ(hw->dmaIrqn);
+	LL_DMA_DisableChannel(hw->dma, hw->dmaChannel);
+
+	DMA_InitStruct.PeriphOrM2MSrcAddress = (uint32_t)&hw->tim->CCR2;
+	DMA_InitStruct.MemoryOrM2MDstAddress = (uint32_t)aTimestamps;
+	DMA_InitStruct.Direction = LL_DMA_DIRECTION_PERIPH_TO_MEMORY;
+	DMA_InitStruct.Mode = LL_DMA_MODE_CIRCULAR;
+	DMA_InitStruct.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+	DMA_InitStruct.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+	DMA_InitStruct.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_HALFWORD;
+	DMA_InitStruct.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_HALFWORD;
+	DMA_InitStruct.NbData = aLength;
+	DMA_InitStruct.PeriphRequest = hw->dmaRequest;
+	DMA_InitStruct.Priority = LL_DMA_PRIORITY_HIGH;
+	LL_DMA_Init(hw->dma, hw->dmaChannel, &DMA_InitStruct);
+
+	IR_dmaClearFlags(hw);
+	// Both handlers convert timestamps, they must not preempt each other
+	NVIC_SetPriority(hw->dmaIrqn, NVIC_GetPriority(hw->irqn));
+	LL_DMA_EnableIT_HT(hw->dma, hw->dmaChannel);
+	LL_DMA_EnableIT_TC(hw->dma, hw->dmaChannel);
+	NVIC_EnableIRQ(hw->dmaIrqn);
+
+	LL_DMA_EnableChannel(hw->dma, hw->dmaChannel);
+}
+#elif defined(USE_TIMER_IC_MODE)
 // Timer reconfiguration for Input Capture mode
-static inline void timerConfigInputCaptureForReceive(void)
+static inline void timerConfigInputCaptureForReceive(const ir_receiver_hw_t *hw)
 {
-	TIM_TypeDef *TIMx = IR_RECEIVE_TIM;
-	IRQn_Type IRQn = IR_RECEIVE_TIM_IRQn;
+	TIM_TypeDef *TIMx = hw->tim;
+	IRQn_Type IRQn = hw->irqn;
 
 	NVIC_DisableIRQ(IRQn);
 	LL_TIM_DeInit(TIMx);
@@ -57,13 +148,13 @@ static inline void timerConfigInputCaptureForReceive(void)
 	LL_GPIO_InitTypeDef GPIO_InitStruct = {0};
 
 	// Configure TIM2_CH2 GPIO pin
-	GPIO_InitStruct.Pin = IRRECEIVE_Pin;
+	GPIO_InitStruct.Pin = hw->pin;
 	GPIO_InitStruct.Mode = LL_GPIO_MODE_ALTERNATE;
 	GPIO_InitStruct.Speed = LL_GPIO_SPEED_FREQ_LOW;
 	GPIO_InitStruct.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
 	GPIO_InitStruct.Pull = LL_GPIO_PULL_NO;
-	GPIO_InitStruct.Alternate = IRRECEIVE_GPIO_AF;
-	LL_GPIO_Init(IRRECEIVE_GPIO_Port, &GPIO_InitStruct);
+	GPIO_InitStruct.Alternate = hw->af;
+	LL_GPIO_Init(hw->port, &GPIO_InitStruct);
 
 	TIM_InitStruct.Prescaler = TIM_PRESCALER;
 	TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
@@ -78,16 +169,24 @@ static inline void timerConfigInputCaptureForReceive(void)
 
 	LL_TIM_IC_SetActiveInput(TIMx, LL_TIM_CHANNEL_CH1, LL_TIM_ACTIVEINPUT_INDIRECTTI);
 	LL_TIM_IC_SetPrescaler(TIMx, LL_TIM_CHANNEL_CH1, LL_TIM_ICPSC_DIV1);
-	LL_TIM_IC_SetFilter(TIMx, LL_TIM_CHANNEL_CH1, LL_TIM_IC_FILTER_FDIV1);
+	LL_TIM_IC_SetFilter(TIMx, LL_TIM_CHANNEL_CH1, IR_IC_FILTER);
 	LL_TIM_IC_SetPolarity(TIMx, LL_TIM_CHANNEL_CH1, LL_TIM_IC_POLARITY_RISING);
 	LL_TIM_IC_SetActiveInput(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_ACTIVEINPUT_DIRECTTI);
 	LL_TIM_IC_SetPrescaler(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_ICPSC_DIV1);
-	LL_TIM_IC_SetFilter(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_IC_FILTER_FDIV1);
+	LL_TIM_IC_SetFilter(TIMx, LL_TIM_CHANNEL_CH2, IR_IC_FILTER);
 	LL_TIM_IC_SetPolarity(TIMx, LL_TIM_CHANNEL_CH2, LL_TIM_IC_POLARITY_FALLING);
+#ifdef USE_TIMER_IC_FREE_RUNNING
+	// CH3 is a plain compare channel used for the end of frame timeout
+	LL_TIM_OC_SetMode(TIMx, LL_TIM_CHANNEL_CH3, LL_TIM_OCMODE_FROZEN);
+#endif
 
 	NVIC_EnableIRQ(IRQn);
 	LL_TIM_EnableIT_CC1(TIMx);
 	LL_TIM_EnableIT_CC2(TIMx);
+#ifdef USE_TIMER_IC_FREE_RUNNING
+	// Overflows extend the 16 bit counter
+	LL_TIM_EnableIT_UPDATE(TIMx);
+#endif
 
 	LL_TIM_CC_EnableChannel(TIMx, LL_TIM_CHANNEL_CH1);
 	LL_TIM_CC_EnableChannel(TIMx, LL_TIM_CHANNEL_CH2);
@@ -96,10 +195,10 @@ static inline void timerConfigInputCaptureForReceive(void)
 }
 #else
 // Timer reconfiguration for periodic mode
-static inline void timerConfigPeriodicForReceive(void)
+static inline void timerConfigPeriodicForReceive(const ir_receiver_hw_t *hw)
 {
-	TIM_TypeDef *TIMx = IR_RECEIVE_TIM;
-	IRQn_Type IRQn = IR_RECEIVE_TIM_IRQn;
+	TIM_TypeDef *TIMx = hw->tim;
+	IRQn_Type IRQn = hw->irqn;
 
 	NVIC_DisableIRQ(IRQn);
 	LL_TIM_DeInit(TIMx);
@@ -135,11 +234,43 @@ static inline void timerConfigPeriodicForReceive(void)
 }
 #endif // USE_TIMER_IC_MODE
 
-void IR_timerConfigForReceive(void)
+void IR_timerConfigForReceive(const ir_receiver_hw_t *hw)
 {
-#ifdef USE_TIMER_IC_MODE
-	timerConfigInputCaptureForReceive();
+#if defined(USE_TIMER_DMA_MODE)
+	timerConfigDMAForReceive(hw);
+#elif defined(USE_TIMER_IC_MODE)
+	timerConfigInputCaptureForReceive(hw);
 #else
-	timerConfigPeriodicForReceive();
+	timerConfigPeriodicForReceive(hw);
 #endif // USE_TIMER_IC_MODE
-}
\ No newline at end of file
+}
+
+#ifdef USE_IR_PROFILE
+#if defined(IR_PROFILE_MOCK)
+volatile uint32_t IR_mockCycles;
+
+void IR_cycleCounterInit(void)
+{
+	IR_mockCycles = 0;
+}
+#else
+void IR_cycleCounterInit(void)
+{
+#if __CORTEX_M >= 3
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	// SysTick is already running for the RTOS kernel
+}
+
+#if __CORTEX_M < 3
+// SysTick counts down and wraps from 0 to LOAD
+uint32_t IR_sysTickSince(uint32_t start)
+{
+	uint32_t now = SysTick->VAL;
+	return start >= now ? start - now : start + SysTick->LOAD + 1 - now;
+}
+#endif
+#endif // IR_PROFILE_MOCK
+#endif // USE_IR_PROFILE
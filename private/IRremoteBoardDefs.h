@@ -34,7 +34,7 @@
 
 /**
  * Defined if the standard IR_enableIRIn function should be used.
- * Undefine for boards supplying their own.
+ * Undefine for boards supplying their own, which should call IR_decodeInit().
  */
 #define USE_DEFAULT_ENABLE_IR_IN
 
@@ -56,6 +56,44 @@
  */
 #define USE_TIMER_IC_MODE
 
+/**
+ * Defined if the input capture timestamps should be moved by DMA into a circular
+ * buffer instead of raising an interrupt for every edge.
+ * The CPU only wakes up on the first edge of a frame, on DMA half/full transfer,
+ * on the end of frame timeout and once per idle time longer than the 65.5 ms timer
+ * period, which clips the gap in front of the next frame to 0xFFFF. Requires USE_TIMER_IC_MODE.
+ * BLINKLED is not supported in this mode.
+ */
+//#define USE_TIMER_DMA_MODE
+
+#if defined(USE_TIMER_DMA_MODE) && ! defined(USE_TIMER_IC_MODE)
+#error "USE_TIMER_DMA_MODE requires USE_TIMER_IC_MODE"
+#endif
+
+/**
+ * Defined if the capture timer should run free in Input Capture mode instead of
+ * being reset on every edge. Durations are the differences of consecutive captures and
+ * overflows are counted in software, so spaces longer than the timer period (e.g. the
+ * gap before a repeat) are measured exactly. The end of a frame is detected by a
+ * compare on CH3, _GAP after the last edge. Requires USE_TIMER_IC_MODE.
+ */
+//#define USE_TIMER_IC_FREE_RUNNING
+
+#if defined(USE_TIMER_IC_FREE_RUNNING) && (! defined(USE_TIMER_IC_MODE) || defined(USE_TIMER_DMA_MODE))
+#error "USE_TIMER_IC_FREE_RUNNING requires USE_TIMER_IC_MODE and is not needed with USE_TIMER_DMA_MODE"
+#endif
+
+/**
+ * Define to measure the cycles spent in the receive ISRs and in every decoder, see irProfile.c.
+ * The numbers are read with IR_profileGet(). Costs a few cycles per ISR entry and decoder call.
+ */
+//#define USE_IR_PROFILE
+
+/**
+ * Define on a host build to take the profiling cycles from IR_mockCycles, which the test advances.
+ */
+//#define IR_PROFILE_MOCK
+
 /**
  * Duty cycle in percent for sent signals.
  */
@@ -101,9 +139,15 @@
 
 //------------------------------------------------------------------------------
 // microseconds per clock interrupt tick
+// Input capture mode keeps the native 1us resolution of the capture timer, so
+// rawbuf holds microseconds and the ISR does not need a (software) divide.
 #if ! defined(MICROS_PER_TICK)
+#ifdef USE_TIMER_IC_MODE
+#define MICROS_PER_TICK    1
+#else
 #define MICROS_PER_TICK    50
 #endif
+#endif
 
 //---------------------------------------------------------
 
@@ -134,7 +178,15 @@
 #ifndef IRRECEIVE_GPIO_AF
 #define IRRECEIVE_GPIO_AF   LL_GPIO_AF_2
 #endif
-#define IR_READPIN          (LL_GPIO_IsInputPinSet(IRRECEIVE_GPIO_Port, IRRECEIVE_Pin))
+/**
+ * Digital input filter of the capture channels (input capture and DMA mode).
+ * The filter samples with fDTS, the undivided timer kernel clock, e.g. LL_TIM_IC_FILTER_FDIV32_N8
+ * needs 8 equal samples at 32 MHz / 32, so pulses shorter than 8 us are ignored by the hardware.
+ */
+#ifndef IR_IC_FILTER
+#define IR_IC_FILTER        LL_TIM_IC_FILTER_FDIV1
+#endif
+#define IR_READPIN(hw)      (LL_GPIO_IsInputPinSet((hw)->port, (hw)->pin))
 
 //---------------------------------------------------------
 
@@ -150,10 +202,76 @@
 #define TIMER_ENABLE_RECEIVE_INTR   NVIC_EnableIRQ(IR_RECEIVE_TIM_IRQn)
 #define TIMER_DISABLE_RECEIVE_INTR  NVIC_DisableIRQ(IR_RECEIVE_TIM_IRQn)
 
-void IR_timerConfigForReceive(void);
+#ifdef USE_TIMER_DMA_MODE
+// DMA channel serving the TIM2_CH2 request (see DMA request mapping in the reference manual)
+#ifndef IR_RECEIVE_DMA
+#define IR_RECEIVE_DMA              DMA1
+#define IR_RECEIVE_DMA_CHANNEL      LL_DMA_CHANNEL_3
+#define IR_RECEIVE_DMA_REQUEST      LL_DMA_REQUEST_8
+#define IR_RECEIVE_DMA_IRQn         DMA1_Channel2_3_IRQn
+#endif
+#endif // USE_TIMER_DMA_MODE
+
+/**
+ * Hardware of one receiver.
+ * The receiver input must be channel 2 of the timer, the other modes also use
+ * channel 1 (capturing the same input) and channel 3 (end of frame timeout).
+ * Every receiver needs a timer of its own.
+ */
+typedef struct {
+    TIM_TypeDef *tim;               ///< Capture (or polling) timer
+    IRQn_Type irqn;                 ///< IRQ of tim, its handler calls IR_receiverIRQHandler()
+    GPIO_TypeDef *port;             ///< Port of the receiver input
+    uint32_t pin;                   ///< LL_GPIO_PIN_x of the receiver input
+    uint32_t af;                    ///< Alternate function connecting the pin to channel 2 of tim
+#ifdef USE_TIMER_DMA_MODE
+    DMA_TypeDef *dma;               ///< DMA serving the channel 2 capture request of tim
+    uint32_t dmaChannel;            ///< LL_DMA_CHANNEL_x
+    uint32_t dmaRequest;            ///< LL_DMA_REQUEST_x
+    IRQn_Type dmaIrqn;              ///< IRQ of dmaChannel, its handler calls IR_receiverDMAIRQHandler()
+#endif
+} ir_receiver_hw_t;
+
+/** Hardware of the default receiver, as set up by the IRRECEIVE_* and IR_RECEIVE_* defines */
+#ifdef USE_TIMER_DMA_MODE
+#define IR_RECEIVER_HW_DEFAULT { IR_RECEIVE_TIM, IR_RECEIVE_TIM_IRQn, IRRECEIVE_GPIO_Port, IRRECEIVE_Pin, IRRECEIVE_GPIO_AF, \
+        IR_RECEIVE_DMA, IR_RECEIVE_DMA_CHANNEL, IR_RECEIVE_DMA_REQUEST, IR_RECEIVE_DMA_IRQn }
+#else
+#define IR_RECEIVER_HW_DEFAULT { IR_RECEIVE_TIM, IR_RECEIVE_TIM_IRQn, IRRECEIVE_GPIO_Port, IRRECEIVE_Pin, IRRECEIVE_GPIO_AF }
+#endif
+
+#ifdef USE_TIMER_DMA_MODE
+void IR_dmaConfigForReceive(const ir_receiver_hw_t *hw, uint16_t *aTimestamps, uint16_t aLength);
+void IR_dmaClearFlags(const ir_receiver_hw_t *hw);
+bool IR_DMAIRQHandler(void);
+#endif // USE_TIMER_DMA_MODE
+
+void IR_timerConfigForReceive(const ir_receiver_hw_t *hw);
 void IR_timerConfigForSend(uint16_t aFrequencyKHz);
 bool IR_TimerIRQHandler(void);
 
+//---------------------------------------------------------
+// Cycle counter of USE_IR_PROFILE.
+// Cortex-M3 and up have the DWT cycle counter. The Cortex-M0+ has none, so the
+// SysTick of the RTOS kernel is used, which counts down from LOAD at the core
+// clock and can measure up to one kernel tick.
+
+#ifdef USE_IR_PROFILE
+#if defined(IR_PROFILE_MOCK)
+extern volatile uint32_t IR_mockCycles;
+#define IR_CYCLE_COUNT()            (IR_mockCycles)
+#define IR_CYCLES_SINCE(start)      (IR_mockCycles - (start))
+#elif __CORTEX_M >= 3
+#define IR_CYCLE_COUNT()            (DWT->CYCCNT)
+#define IR_CYCLES_SINCE(start)      (DWT->CYCCNT - (start))
+#else
+#define IR_CYCLE_COUNT()            (SysTick->VAL)
+#define IR_CYCLES_SINCE(start)      IR_sysTickSince(start)
+uint32_t IR_sysTickSince(uint32_t start);
+#endif
+void IR_cycleCounterInit(void);
+#endif // USE_IR_PROFILE
+
 //---------------------------------------------------------
 
 
@@ -24,31 +24,373 @@
 //------------------------------------------------------------------------------
 // Information for the Interrupt Service Routine
 //
+/**
+ * Define to store each raw duration in one byte of IR_COMPACT_MICROS units instead of
+ * a 16 bit tick count, so the same RAM holds almost twice as many entries.
+ * Durations which do not fit (practically only the gap) are kept exactly in a small
+ * per frame table of IR_COMPACT_LONG_LENGTH slots and the byte refers to their slot.
+ * A frame with more long durations is flagged as overflow and IR_decode() drops it.
+ * Decoders read the buffer through IR_RAW(), which yields ticks in either format.
+ */
+//#define USE_IR_COMPACT_RAWBUF
+
+#ifdef USE_IR_COMPACT_RAWBUF
+#if ! defined(IR_COMPACT_MICROS)
+#define IR_COMPACT_MICROS       50      ///< Unit of a compact raw entry
+#endif
+#define IR_COMPACT_TICKS        (IR_COMPACT_MICROS / MICROS_PER_TICK)
+#define IR_COMPACT_LONG_LENGTH  4       ///< Number of long durations per frame
+#define IR_COMPACT_LONG_BASE    (0x100 - IR_COMPACT_LONG_LENGTH) ///< Entries from here on refer to rawlong[entry - IR_COMPACT_LONG_BASE]
+
+#if IR_COMPACT_TICKS < 1 || (IR_COMPACT_MICROS % MICROS_PER_TICK)
+#error "IR_COMPACT_MICROS must be a multiple of MICROS_PER_TICK"
+#endif
+
+typedef uint8_t irraw_t;
+#if ! defined(RAW_BUFFER_LENGTH)
+#define RAW_BUFFER_LENGTH  193  ///< Maximum length of raw duration buffer. Must be odd.
+#endif
+#else
+typedef uint16_t irraw_t;
 #if ! defined(RAW_BUFFER_LENGTH)
 #define RAW_BUFFER_LENGTH  101  ///< Maximum length of raw duration buffer. Must be odd.
 #endif
+#endif // USE_IR_COMPACT_RAWBUF
+
+/**
+ * Number of complete frames the ISR can queue for the decoder.
+ * The ISR keeps capturing into the next free slot while older frames wait to be decoded.
+ * Set to 1 to get the classic single buffer behaviour. Must be a power of two.
+ */
+#if ! defined(IR_FRAME_RING_LENGTH)
+#define IR_FRAME_RING_LENGTH  2
+#endif
+
+#if (IR_FRAME_RING_LENGTH & (IR_FRAME_RING_LENGTH - 1)) || IR_FRAME_RING_LENGTH > 128
+#error "IR_FRAME_RING_LENGTH must be a power of two not greater than 128"
+#endif
+
+/**
+ * Number of edge timestamps in the circular DMA buffer (USE_TIMER_DMA_MODE only).
+ * Half of it must be able to hold all edges arriving within one end of frame timeout.
+ * Must be even.
+ */
+#if ! defined(IR_DMA_BUFFER_LENGTH)
+#define IR_DMA_BUFFER_LENGTH  64
+#endif
+
+/**
+ * Define to hand the durations over to the decoder through a lock-free single-producer /
+ * single-consumer FIFO instead of the frame ring.
+ * The ISR pushes every duration up to RAW_BUFFER_LENGTH + 1 per frame, the rest would only
+ * overflow rawbuf. The decoder task drains the FIFO in IR_decode() and assembles the frame
+ * in its own buffer. The ISR never has to wait for IR_resume().
+ */
+//#define USE_IR_EDGE_FIFO
+
+/**
+ * Number of durations the edge FIFO can hold (USE_IR_EDGE_FIFO only). Must be a power of two.
+ */
+#if ! defined(IR_EDGE_FIFO_LENGTH)
+#define IR_EDGE_FIFO_LENGTH  256
+#endif
+
+#if (IR_EDGE_FIFO_LENGTH & (IR_EDGE_FIFO_LENGTH - 1))
+#error "IR_EDGE_FIFO_LENGTH must be a power of two"
+#endif
+
+/**
+ * Define to run the streaming decoder (irStream.c) on every duration while the edge FIFO
+ * is drained, so the result of the pulse distance protocols is known with the last edge
+ * and IR_decode() does not need to scan the frame again. Requires USE_IR_EDGE_FIFO.
+ */
+//#define USE_IR_STREAM_DECODE
+
+#if defined(USE_IR_STREAM_DECODE) && ! defined(USE_IR_EDGE_FIFO)
+#error "USE_IR_STREAM_DECODE requires USE_IR_EDGE_FIFO"
+#endif
+
+/**
+ * Define to decode the frames of one pulse distance protocol of any length, see IR_setLongFrames().
+ * The ISR packs the bits into a buffer of the caller as the edges come in, so a 300 bit air
+ * conditioner frame takes 38 bytes instead of 601 rawbuf entries, and the edge FIFO only needs
+ * room for the durations which fit rawbuf. Requires USE_IR_EDGE_FIFO.
+ */
+//#define USE_IR_LONG_FRAMES
+
+#if defined(USE_IR_LONG_FRAMES) && ! defined(USE_IR_EDGE_FIFO)
+#error "USE_IR_LONG_FRAMES requires USE_IR_EDGE_FIFO"
+#endif
+
+#if defined(USE_IR_LONG_FRAMES) && IR_EDGE_FIFO_LENGTH < RAW_BUFFER_LENGTH + 2
+#error "USE_IR_LONG_FRAMES requires an IR_EDGE_FIFO_LENGTH of at least RAW_BUFFER_LENGTH + 2"
+#endif
+
+/**
+ * Define to answer a held key from a cache instead of the decoders. Protocols without a repeat
+ * code (JVC, Sharp, RC5, RC6, ...) send the full frame again every 40 to 110 ms. A frame with the
+ * length of the last decoded one and all durations within TOLERANCE of it, arriving within
+ * IR_REPEAT_CACHE_MS, gets the cached result with isRepeat set. Costs 2 * RAW_BUFFER_LENGTH
+ * bytes per receiver. Keep it above the repeat period of the used protocols and below the time
+ * between two presses. Sony, Sanyo and Sharp Alt, whose decoders read the gap in front of the
+ * frame, and hashed frames are always decoded.
+ */
+//#define IR_REPEAT_CACHE_MS      150
+
+/**
+ * Define to hand a frame over as soon as its structure is complete for one of the pulse distance
+ * protocols of the streaming decoder, e.g. 68 entries of NEC ending with the stop mark or the
+ * 4 entries of a NEC repeat, instead of waiting for the gap. This saves _GAP (periodic mode)
+ * or the timer overflow (input capture mode) of latency per frame.
+ * The ISR follows every duration of the frame with the candidates of the streaming decoder, a frame
+ * is only handed over early when a candidate has matched all of it. Frames which could still be longer,
+ * for a candidate or for any other enabled decoder taking the same first mark, wait for the gap as usual.
+ * This needs a narrowed protocol set: with all protocols enabled the long MagiQuest and the header-less
+ * decoders keep every frame waiting (test/bench_latency shows the full gap for each frame of the default
+ * set), so narrow the protocols down with IR_setProtocols() to the ones in use.
+ * JVC frames end early only while NEC is disabled, the JVC header is within TOLERANCE of the NEC header,
+ * so the NEC candidate stays live and still expects 68 entries where JVC has 36. The header-less JVC repeat
+ * always waits for the gap, the candidates only follow frames which start with a header.
+ * In DMA mode the prediction only runs when a batch of timestamps is converted.
+ */
+//#define USE_IR_EARLY_FRAME_END
+
+/**
+ * Define to reject glitches in the ISR. A mark or space shorter than IR_MIN_PULSE_MICROS is
+ * treated as a spike: it is merged together with the following duration into the preceding one,
+ * so the decoder sees one long mark instead of mark, spike, mark. This costs one entry of latency
+ * because the latest duration is held back until the next one is known.
+ * Choose it well below the shortest mark or space of the used protocols, e.g. 100 for 560 us NEC bits.
+ * See also IR_IC_FILTER for the hardware input filter of the input capture modes.
+ */
+//#define IR_MIN_PULSE_MICROS     100
+
+#ifdef IR_MIN_PULSE_MICROS
+#define IR_MIN_PULSE_TICKS      (IR_MIN_PULSE_MICROS / MICROS_PER_TICK)
+#endif
+
+/**
+ * Define to protect the system against interrupt storms, e.g. sunlight, CFL ballasts or plasma
+ * panels making the demodulator output toggle constantly. If more than IR_STORM_EDGES edges arrive
+ * within IR_STORM_WINDOW_MS, the frame in progress is discarded and the capture interrupts are masked
+ * for IR_STORM_BACKOFF_MS. The backoff doubles with every storm that follows directly on the previous
+ * one, up to IR_STORM_BACKOFF_MAX_MS, and starts over after a window below the limit.
+ * Remotes produce less than 20 edges per 10 ms, so the default limit is far above any real frame.
+ * Input capture modes only: in DMA mode there is no interrupt per edge and periodic mode has a fixed rate.
+ */
+//#define IR_STORM_EDGES          100
+
+#ifdef IR_STORM_EDGES
+#ifndef IR_STORM_WINDOW_MS
+#define IR_STORM_WINDOW_MS      10      ///< Length of the window the edges are counted in
+#endif
+#ifndef IR_STORM_BACKOFF_MS
+#define IR_STORM_BACKOFF_MS     20      ///< Capture interrupts are masked this long after the first storm
+#endif
+#ifndef IR_STORM_BACKOFF_MAX_MS
+#define IR_STORM_BACKOFF_MAX_MS 1280    ///< Upper limit of the doubled backoff
+#endif
+#if ! defined(USE_TIMER_IC_MODE) || defined(USE_TIMER_DMA_MODE)
+#error "IR_STORM_EDGES requires USE_TIMER_IC_MODE without USE_TIMER_DMA_MODE"
+#endif
+#endif
+
+#define IR_EDGE_FRAME_START   0x8000  ///< Flag of the first entry (the gap) of a frame in the edge FIFO
+#define IR_EDGE_FRAME_END     0xFFFF  ///< Token pushed into the edge FIFO when a frame is complete
+#define IR_EDGE_LONG_FRAME_END 0xFFFE ///< Same for a frame the long frame decoder took (USE_IR_LONG_FRAMES)
+#define IR_EDGE_MAX_DURATION  0x7FFD  ///< Longer durations are clipped, a gap never looks like a token
 
 // ISR State-Machine : Receiver States
 #define IR_REC_STATE_IDLE      0
 #define IR_REC_STATE_MARK      1
 #define IR_REC_STATE_SPACE     2
-#define IR_REC_STATE_STOP      3
+#define IR_REC_STATE_STOP      3    ///< Frame ring is full, incoming frames are dropped
+
+/**
+ * One captured frame.
+ * Written by the ISR while it is the capture slot, read by the decoder once committed.
+ */
+struct irframe_struct {
+    uint16_t rawlen;                ///< counter of entries in rawbuf
+    irraw_t rawbuf[RAW_BUFFER_LENGTH]; ///< raw data, first entry is the length of the gap between previous and current command
+    uint8_t overflow;               ///< Raw buffer overflow occurred
+#ifdef USE_IR_COMPACT_RAWBUF
+    uint8_t longCount;              ///< Number of used rawlong slots
+    uint8_t clipped;                ///< A long duration found no rawlong slot, the frame is not decoded
+    uint16_t rawlong[IR_COMPACT_LONG_LENGTH]; ///< Durations too long for a compact entry, in ticks
+#endif
+};
+
+//------------------------------------------------------------------------------
+// Raw buffer access.
+// IR_rawStore() writes the duration of entry index in the capture format,
+// IR_rawValue() reads it back in ticks.
+//
+#ifdef USE_IR_COMPACT_RAWBUF
+static inline void IR_rawStore(struct irframe_struct *frame, uint16_t index, uint16_t ticks) {
+    if (index == 0) {
+        frame->longCount = 0;
+        frame->clipped = false;
+    }
+    if (ticks < IR_COMPACT_LONG_BASE * IR_COMPACT_TICKS - IR_COMPACT_TICKS / 2) {
+#if IR_COMPACT_TICKS == 1
+        frame->rawbuf[index] = ticks;
+#else
+        // Rounded division by a multiply and shift, there is no divide instruction on Cortex-M0+.
+        // Exact for the range checked above.
+        frame->rawbuf[index] = ((uint32_t)(ticks + IR_COMPACT_TICKS / 2)
+                * ((0x100000UL + IR_COMPACT_TICKS - 1) / IR_COMPACT_TICKS)) >> 20;
+#endif
+    } else if (frame->longCount < IR_COMPACT_LONG_LENGTH) {
+        frame->rawlong[frame->longCount] = ticks;
+        frame->rawbuf[index] = IR_COMPACT_LONG_BASE + frame->longCount++;
+    } else {
+        // No slot left, the duration is lost
+        frame->rawbuf[index] = IR_COMPACT_LONG_BASE - 1;
+        frame->clipped = true;
+        frame->overflow = true;
+    }
+}
+
+static inline uint16_t IR_rawValue(const irraw_t *rawbuf, const uint16_t *rawlong, uint16_t index) {
+    uint8_t entry = rawbuf[index];
+    if (entry >= IR_COMPACT_LONG_BASE) {
+        return rawlong[entry - IR_COMPACT_LONG_BASE];
+    }
+    return entry * IR_COMPACT_TICKS;
+}
+#else
+static inline void IR_rawStore(struct irframe_struct *frame, uint16_t index, uint16_t ticks) {
+    frame->rawbuf[index] = ticks;
+}
+#endif // USE_IR_COMPACT_RAWBUF
+
+/**
+ * Single-producer / single-consumer FIFO of durations.
+ * head is only written by the ISR, tail only by the decoder, so no critical section is needed.
+ * Both indices are free running, the slot of an index is (index & (IR_EDGE_FIFO_LENGTH - 1)).
+ */
+struct iredgefifo_struct {
+    volatile uint16_t head;         ///< Number of entries pushed by the ISR
+    volatile uint16_t tail;         ///< Number of entries popped by the decoder
+    volatile uint16_t overruns;     ///< Number of entries the ISR had to discard because the FIFO was full
+    uint16_t buf[IR_EDGE_FIFO_LENGTH];
+};
 
 /**
- * This struct is used for the ISR (interrupt service routine)
- * and is copied once only in state STATE_STOP, so only rcvstate needs to be volatile.
+ * Counters of the ISR. The ISR makes sequence odd while it updates them, so the
+ * decoder side takes a consistent copy without blocking the ISR (sequence lock).
+ */
+struct irisrstats_struct {
+    volatile uint32_t sequence;     ///< Odd while an update is in progress
+    uint32_t frames;                ///< Frames committed
+    uint32_t edges;                 ///< Entries of the committed frames, including the gaps
+    uint32_t dropped;               ///< Frames discarded because the ring was full
+    uint32_t storms;                ///< Interrupt storms (IR_STORM_EDGES)
+};
+
+#ifdef USE_IR_EARLY_FRAME_END
+/**
+ * State of the end of frame predictor (USE_IR_EARLY_FRAME_END), updated by the ISR with each entry.
+ * The candidates are those of the streaming decoder, see IR_streamTrack().
+ */
+struct irframeend_struct {
+    uint16_t live;                  ///< Candidates which matched every duration so far
+    uint16_t repeat;                ///< Candidates which see a repeat frame
+    uint16_t disabled;              ///< Candidates of disabled protocols
+    uint16_t firstMark;             ///< First mark of the current frame
+    uint32_t disabledProtocols;     ///< Copy of the disabled protocols of the receiver, see IR_frameMayGrow()
+};
+#endif
+
+/**
+ * This struct is used for the ISR (interrupt service routine), there is one per receiver.
+ * Frames are handed over through the head/tail counters: the ISR only advances head,
+ * IR_resume() only advances tail, so a committed frame is never touched by the ISR.
+ * Both counters are free running, the slot of a counter is (counter % IR_FRAME_RING_LENGTH).
  */
 struct irparams_struct {
     // The fields are ordered to reduce memory over caused by struct-padding
     volatile uint8_t rcvstate;      ///< State Machine state
     uint8_t blinkflag;              ///< true -> enable blinking of pin on IR processing
-    uint16_t rawlen;                ///< counter of entries in rawbuf
-    uint16_t timer;             ///< State timer, counts 50uS ticks.
-    uint16_t rawbuf[RAW_BUFFER_LENGTH]; ///< raw data, first entry is the length of the gap between previous and current command
-    uint8_t overflow;               ///< Raw buffer overflow occurred
+    volatile uint8_t head;          ///< Number of frames committed by the ISR, also counted with USE_IR_EDGE_FIFO
+    volatile uint8_t tail;          ///< Number of frames released by IR_resume()
+    uint16_t timer;                 ///< State timer, counts 50uS ticks (periodic mode only).
+    uint8_t dropping;               ///< true while a frame is discarded because the ring is full
+    uint16_t frameEntries;          ///< Entries of the current frame, including the gap
+#ifdef USE_IR_EARLY_FRAME_END
+    struct irframeend_struct frameEnd;  ///< End of frame predictor
+#endif
+#ifdef IR_MIN_PULSE_MICROS
+    uint16_t held;                  ///< Latest duration, held back by the glitch filter
+    uint8_t holding;                ///< true if held is valid
+    uint8_t merging;                ///< true if the next duration is merged into held after a spike
+#endif
+#ifdef IR_STORM_EDGES
+    uint8_t storming;               ///< true while the capture interrupts are masked
+    uint16_t stormEdges;            ///< Edges counted in the current window
+    uint16_t stormBackoff;          ///< Length of the next backoff, in ms
+    uint32_t stormTime;             ///< Start of the current window, or end of the backoff while storming, in ms
+#endif
+    struct irisrstats_struct stats; ///< Health counters, see IR_receiverGetStats()
+#ifdef USE_IR_EDGE_FIFO
+    struct iredgefifo_struct edges; ///< Durations on their way to the decoder
+#ifdef USE_IR_LONG_FRAMES
+    struct irlongframe_struct *longFrame; ///< Fed by the ISR, see IR_setLongFrames(). NULL if never set
+    volatile uint8_t longFrameReady;    ///< longFrame holds a frame until IR_resume(), the ISR leaves it alone
+#endif
+#else
+    struct irframe_struct frames[IR_FRAME_RING_LENGTH]; ///< Frame ring
+#endif
+#ifdef USE_TIMER_IC_FREE_RUNNING
+    uint16_t overflows;             ///< Number of capture timer overflows, upper half of the timestamps
+    uint32_t lastCapture;           ///< Extended timestamp of the last edge, 1 us resolution
+#endif
+#ifdef USE_TIMER_DMA_MODE
+    uint16_t dmaRead;               ///< Index of the next timestamp to be converted
+    uint16_t lastEdge;              ///< Timestamp of the last converted edge
+    uint8_t dmaMark;                ///< true if the last converted edge started a mark
+    uint8_t dmaLongGap;             ///< true if the counter has come round since the last edge, the next gap is clipped to 0xFFFF
+    uint16_t timestamps[IR_DMA_BUFFER_LENGTH]; ///< Edge timestamps written by DMA, 1 us resolution
+#endif
 };
 
-extern struct irparams_struct irparams;
+/** Frame the ISR is currently capturing into */
+#define IR_CAPTURE_FRAME(params)  (&(params)->frames[(params)->head % IR_FRAME_RING_LENGTH])
+/** Oldest committed frame, valid only if IR_FRAMES_PENDING() */
+#define IR_DECODE_FRAME(params)   (&(params)->frames[(params)->tail % IR_FRAME_RING_LENGTH])
+/** Number of committed frames waiting for the decoder */
+#define IR_FRAMES_PENDING(params) ((uint8_t)((params)->head - (params)->tail))
+
+#ifdef USE_IR_EDGE_FIFO
+//------------------------------------------------------------------------------
+// Edge FIFO access. Push is called from the ISR only, pop from the decoder only.
+// The barrier makes the entry visible before the index that publishes it.
+//
+static inline bool IR_edgeFifoPush(struct iredgefifo_struct *fifo, uint16_t entry) {
+    uint16_t head = fifo->head;
+    if ((uint16_t)(head - fifo->tail) >= IR_EDGE_FIFO_LENGTH) {
+        fifo->overruns++;
+        return false;
+    }
+    fifo->buf[head & (IR_EDGE_FIFO_LENGTH - 1)] = entry;
+    __DMB();
+    fifo->head = head + 1;
+    return true;
+}
+
+static inline bool IR_edgeFifoPop(struct iredgefifo_struct *fifo, uint16_t *entry) {
+    uint16_t tail = fifo->tail;
+    if (tail == fifo->head) {
+        return false;
+    }
+    __DMB();
+    *entry = fifo->buf[tail & (IR_EDGE_FIFO_LENGTH - 1)];
+    __DMB();
+    fifo->tail = tail + 1;
+    return true;
+}
+#endif // USE_IR_EDGE_FIFO
 
 //------------------------------------------------------------------------------
 // Defines for setting and clearing register bits
@@ -97,11 +439,20 @@ extern struct irparams_struct irparams;
 #if MICROS_PER_TICK == 50 && TOLERANCE == 25           // Defaults
 #define TICKS_LOW(us)   ((us)/67 )     // (us) / ((MICROS_PER_TICK:50 / LTOL:75 ) * 100)
 #define TICKS_HIGH(us)  ((us)/40 + 1)  // (us) / ((MICROS_PER_TICK:50 / UTOL:125) * 100) + 1
+#elif MICROS_PER_TICK == 1 && TOLERANCE == 25         // Input capture mode
+#define TICKS_LOW(us)   ((us) - (us)/4)      // (us) * LTOL:75 / 100
+#define TICKS_HIGH(us)  ((us) + (us)/4 + 1)  // (us) * UTOL:125 / 100 + 1
 #else
     #define TICKS_LOW(us)   ((uint16_t) ((long) (us) * LTOL / (MICROS_PER_TICK * 100) ))
     #define TICKS_HIGH(us)  ((uint16_t) ((long) (us) * UTOL / (MICROS_PER_TICK * 100) + 1))
 #endif
 
+/** TICKS_LOW() and TICKS_HIGH() with a tolerance of their own, in percent. Constant for constant arguments. */
+#define TICKS_LOW_TOL(us, tolerance)  ((tolerance) == TOLERANCE ? TICKS_LOW(us) \
+        : (uint16_t) ((long) (us) * (100 - (tolerance)) / (MICROS_PER_TICK * 100)))
+#define TICKS_HIGH_TOL(us, tolerance) ((tolerance) == TOLERANCE ? TICKS_HIGH(us) \
+        : (uint16_t) ((long) (us) * (100 + (tolerance)) / (MICROS_PER_TICK * 100) + 1))
+
 //------------------------------------------------------------------------------
 // IR detector output is active low
 //
@@ -0,0 +1,468 @@
+/**
+ * @file bench_decode.c
+ * @brief Cost of the decode dispatch per protocol, and check of the decoder signatures.
+ *
+ * Clean and jittered frames of every protocol go through the simulated receiver.
+ * dispatchFrame(), which only calls the decoders whose signature fits, is timed
+ * against the chain it replaced: every enabled decoder in turn, the hash decoder
+ * last. Both get the same frame in alternating batches and must come to the same
+ * result. Every frame, truncated ones and random ones are also given to every
+ * decoder directly: a decoder accepting a frame its signatures exclude is a
+ * failure, dispatch would never have called it. The last row is random frames,
+ * which no decoder takes.
+ */
+#include <time.h>
+
+#include "ir_mock.h"
+#include "ir_test.h"
+
+// Built into the benchmark instead of the library, for decoders[] and dispatchFrame()
+#include "irReceive.c"
+
+#define FRAME_GAP       60000   // longer than the repeat spaces of Sony, Sanyo and Sharp Alt
+#define VARIANTS        16      // frames per protocol, the first one without jitter
+#define REPEATS         200     // timed calls per batch
+#define ROUNDS          5       // batches per frame and side, the fastest one counts
+#define RANDOM_FRAMES   20000
+
+typedef struct {
+    uint16_t length;                        ///< Entries including the gap
+    uint16_t durations[RAW_BUFFER_LENGTH];  ///< In us, durations[0] is the gap
+} frame_t;
+
+//+=============================================================================
+// Frame generators
+//
+static uint32_t seed = 0x2545F491;
+
+static uint32_t nextRandom(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void begin(frame_t *frame) {
+    frame->durations[0] = FRAME_GAP;
+    frame->length = 1;
+}
+
+static void put(frame_t *frame, uint16_t us) {
+    if (frame->length < RAW_BUFFER_LENGTH) {
+        frame->durations[frame->length++] = us;
+    }
+}
+
+// Mark and space per bit, the space tells the value
+static void pulseDistance(frame_t *frame, uint16_t bitMark, uint16_t oneSpace, uint16_t zeroSpace,
+        uint8_t bits, uint64_t value, bool msbFirst) {
+    for (uint8_t i = 0; i < bits; i++) {
+        bool one = (value >> (msbFirst ? bits - 1 - i : i)) & 1;
+        put(frame, bitMark);
+        put(frame, one ? oneSpace : zeroSpace);
+    }
+}
+
+// Half bits of unit us, 1 is a mark. Equal neighbours merge, the trailing space is the gap.
+static void halfBits(frame_t *frame, const uint8_t *levels, uint8_t count, uint16_t unit) {
+    uint16_t run = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        run += unit;
+        if (i + 1 == count || levels[i + 1] != levels[i]) {
+            if (levels[i] || i + 1 < count) {
+                put(frame, run);
+            }
+            run = 0;
+        }
+    }
+}
+
+static void sendNEC(frame_t *frame, uint32_t value) {
+    put(frame, 9000);
+    put(frame, 4500);
+    pulseDistance(frame, 560, 1690, 560, 32, value, true);
+    put(frame, 560);
+}
+
+static void sendNECRepeat(frame_t *frame, uint32_t value) {
+    (void)value;
+    put(frame, 9000);
+    put(frame, 2250);
+    put(frame, 560);
+}
+
+static void sendSony(frame_t *frame, uint32_t value) {
+    put(frame, 2400);
+    for (uint8_t i = 0; i < 12; i++) {
+        put(frame, 600);
+        put(frame, (value >> (11 - i)) & 1 ? 1200 : 600);
+    }
+}
+
+static void sendRC5(frame_t *frame, uint32_t value) {
+    uint8_t levels[2 * 14];
+    uint8_t count = 0;
+
+    // start bits and 12 bits, a 1 is space then mark
+    for (uint8_t i = 0; i < 14; i++) {
+        bool one = i < 2 || ((value >> (13 - i)) & 1);
+        levels[count++] = !one;
+        levels[count++] = one;
+    }
+    // the first half of the start bit is no edge
+    halfBits(frame, levels + 1, count - 1, 889);
+}
+
+static void sendRC6(frame_t *frame, uint32_t value) {
+    uint8_t levels[6 + 2 + 2 + 2 * 21];
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        levels[count++] = 1;    // header mark
+    }
+    levels[count++] = 0;        // header space
+    levels[count++] = 0;
+    levels[count++] = 1;        // start bit
+    levels[count++] = 0;
+    // 20 bits, a 1 is mark then space, the fourth one is the double width trailer bit
+    for (uint8_t i = 0; i < 20; i++) {
+        bool one = (value >> (19 - i)) & 1;
+        levels[count++] = one;
+        if (i == 3) {
+            levels[count++] = one;
+        }
+        levels[count++] = !one;
+        if (i == 3) {
+            levels[count++] = !one;
+        }
+    }
+    halfBits(frame, levels, count, 444);
+}
+
+static void sendPanasonic(frame_t *frame, uint32_t value) {
+    put(frame, 3502);
+    put(frame, 1750);
+    pulseDistance(frame, 502, 1244, 400, 48, ((uint64_t)0x4004 << 32) | value, true);
+    put(frame, 502);
+}
+
+static void sendLG(frame_t *frame, uint32_t value) {
+    put(frame, 8400);
+    put(frame, 4200);
+    pulseDistance(frame, 600, 1600, 550, 28, value, true);
+    put(frame, 600);
+}
+
+static void sendJVC(frame_t *frame, uint32_t value) {
+    put(frame, 8400);
+    put(frame, 4200);
+    pulseDistance(frame, 600, 1600, 550, 16, value, true);
+    put(frame, 600);
+}
+
+static void sendJVCRepeat(frame_t *frame, uint32_t value) {
+    pulseDistance(frame, 600, 1600, 550, 16, value, true);
+    put(frame, 600);
+}
+
+static void sendSamsung(frame_t *frame, uint32_t value) {
+    put(frame, 4500);
+    put(frame, 4500);
+    pulseDistance(frame, 560, 1600, 560, 32, value, true);
+    put(frame, 560);
+}
+
+static void sendSamsungRepeat(frame_t *frame, uint32_t value) {
+    (void)value;
+    put(frame, 4500);
+    put(frame, 2250);
+    put(frame, 560);
+}
+
+static void sendWhynter(frame_t *frame, uint32_t value) {
+    put(frame, 750);
+    put(frame, 750);
+    put(frame, 2850);
+    put(frame, 2850);
+    pulseDistance(frame, 750, 2150, 750, 32, value, true);
+    put(frame, 750);
+}
+
+static void sendSanyo(frame_t *frame, uint32_t value) {
+    put(frame, 3500);
+    put(frame, 3500);
+    for (uint8_t i = 0; i < 12; i++) {
+        put(frame, 950);
+        put(frame, (value >> (11 - i)) & 1 ? 2400 : 700);
+    }
+}
+
+// The decoder checks the first mark for 150 us and the others for 250 us
+static void sendSharp(frame_t *frame, uint32_t value) {
+    pulseDistance(frame, 198, 1805, 795, 13, value, true);
+    pulseDistance(frame, 198, 1805, 795, 2, 2, true);   // expansion and check bit
+    put(frame, 198);
+}
+
+static void sendSharpAlt(frame_t *frame, uint32_t value) {
+    pulseDistance(frame, 150, 1750, 700, 13, value, false);
+    pulseDistance(frame, 150, 1750, 700, 2, 1, false);  // expansion and check bit
+    put(frame, 150);
+}
+
+static void sendDenon(frame_t *frame, uint32_t value) {
+    put(frame, 300);
+    put(frame, 750);
+    pulseDistance(frame, 300, 1800, 750, 14, value, true);
+    put(frame, 300);
+}
+
+static void sendLego(frame_t *frame, uint32_t value) {
+    put(frame, 158);
+    put(frame, 1026);
+    pulseDistance(frame, 158, 553, 263, 16, value, true);
+    put(frame, 158);
+}
+
+static void sendMagiQuest(frame_t *frame, uint32_t value) {
+    for (uint8_t i = 0; i < 50; i++) {
+        bool one = i >= 8 && ((((uint64_t)value << 10) >> (49 - i)) & 1);
+        put(frame, one ? 575 : 288);
+        put(frame, one ? 575 : 862);
+    }
+    put(frame, 288);
+}
+
+static const struct {
+    const char *name;
+    void (*send)(frame_t *frame, uint32_t value);
+} protocols[] = {
+    { "NEC", sendNEC },
+    { "NEC repeat", sendNECRepeat },
+    { "Sony", sendSony },
+    { "RC5", sendRC5 },
+    { "RC6", sendRC6 },
+    { "Panasonic", sendPanasonic },
+    { "LG", sendLG },
+    { "JVC", sendJVC },
+    { "JVC repeat", sendJVCRepeat },
+    { "Samsung", sendSamsung },
+    { "Samsung rpt", sendSamsungRepeat },
+    { "Whynter", sendWhynter },
+    { "Sanyo", sendSanyo },
+    { "Sharp", sendSharp },
+    { "Sharp Alt", sendSharpAlt },
+    { "Denon", sendDenon },
+    { "Lego PF", sendLego },
+    { "MagiQuest", sendMagiQuest },
+};
+
+#define PROTOCOLS   (sizeof(protocols) / sizeof(protocols[0]))
+
+// Random durations out of the timings of all protocols, jittered
+static void generateRandom(frame_t *frame) {
+    static const uint16_t timings[] = {
+        150, 198, 250, 288, 300, 400, 444, 502, 550, 560, 575, 600, 700, 750, 795, 862, 889, 950,
+        1026, 1200, 1244, 1600, 1690, 1750, 1800, 1805, 2150, 2250, 2400, 2666, 2850, 3500, 4200,
+        4500, 8400, 9000,
+    };
+
+    frame->durations[0] = nextRandom() & 1 ? FRAME_GAP : 300;
+    frame->length = 2 + nextRandom() % (RAW_BUFFER_LENGTH - 1);
+    for (uint16_t i = 1; i < frame->length; i++) {
+        uint16_t us = timings[nextRandom() % (sizeof(timings) / sizeof(timings[0]))];
+        if (!(i & 1) && us > 4500) {
+            us = 4500; // a longer space would end the frame
+        }
+        frame->durations[i] = us + us * ((int32_t)(nextRandom() % 41) - 20) / 100;
+    }
+}
+
+// Frame of a protocol, all durations scaled by up to +-jitter percent.
+// Protocol PROTOCOLS is a random frame.
+static void generate(frame_t *frame, uint8_t protocol, uint8_t jitter) {
+    if (protocol == PROTOCOLS) {
+        generateRandom(frame);
+        return;
+    }
+    begin(frame);
+    protocols[protocol].send(frame, nextRandom());
+    for (uint16_t i = 1; jitter && i < frame->length; i++) {
+        int32_t percent = (int32_t)(nextRandom() % (2 * jitter + 1)) - jitter;
+        frame->durations[i] += frame->durations[i] * percent / 100;
+    }
+}
+
+//+=============================================================================
+// Signature check
+//
+static uint32_t accepted[DECODERS];
+static uint32_t violations;
+
+// Give the frame to every decoder, each one has to be excluded by its signatures if it fails
+static void checkSignatures(const frame_t *frame) {
+    static irraw_t rawbuf[RAW_BUFFER_LENGTH];
+    ir_decode_results results;
+
+    for (uint16_t i = 0; i < frame->length; i++) {
+        rawbuf[i] = frame->durations[i] / MICROS_PER_TICK;
+    }
+    uint16_t firstMark = frame->length > 1 ? rawbuf[1] : 0;
+
+    for (uint8_t d = 0; d < DECODERS; d++) {
+        memset(&results, 0, sizeof(results));
+        results.rawbuf = rawbuf;
+        results.rawlen = frame->length;
+        if (!decoders[d]->decode(&results)) {
+            continue;
+        }
+        accepted[d]++;
+        if (!signatureMatches(&decoders[d]->signatures[0], firstMark, frame->length)
+                && !signatureMatches(&decoders[d]->signatures[1], firstMark, frame->length)) {
+            if (violations++ < 10) {
+                printf("decode type %d accepts a frame of %u entries with first mark %u outside of its signatures\n",
+                        decoders[d]->decode_type, frame->length, firstMark);
+            }
+        }
+    }
+}
+
+//+=============================================================================
+// Decode cost
+//
+static uint64_t nanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void transmit(const frame_t *frame) {
+    for (uint16_t i = 1; i < frame->length; i++) {
+        if (i & 1) {
+            IR_mockMark(frame->durations[i]);
+        } else {
+            IR_mockSpace(frame->durations[i]);
+        }
+    }
+    IR_mockSpace(FRAME_GAP);
+}
+
+// IR_decode() before the dispatch by signature: every enabled decoder in turn, the hash decoder last
+static bool decodeInTurn(ir_receiver_t *receiver, ir_decode_results *results) {
+    for (uint8_t i = 0; i < DECODERS; i++) {
+        const ir_decoder_t *decoder = decoders[i];
+
+        if (receiver->disabledProtocols & protocolBit(decoder->decode_type)) {
+            continue;
+        }
+        if (decoder->decode(results)) {
+            countDecoded(receiver, decoder->decode_type);
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct {
+    uint64_t total;
+    uint64_t worst;
+} cost_t;
+
+// Time of one call, the best of ROUNDS batches of REPEATS calls
+static void account(cost_t *cost, uint64_t best) {
+    cost->total += best;
+    if (best > cost->worst) {
+        cost->worst = best;
+    }
+}
+
+static void measure(uint8_t protocol, cost_t *dispatched, cost_t *sequential) {
+    ir_decode_results results;
+    frame_t frame;
+
+    for (uint8_t variant = 0; variant < VARIANTS; variant++) {
+        generate(&frame, protocol, variant == 0 ? 0 : 15);
+        checkSignatures(&frame);
+        transmit(&frame);
+        if (!IR_available(&results)) {
+            CHECK(!"frame received");
+            continue;
+        }
+
+        // Both sides take turns, so they see the same caches and clock
+        uint64_t bestDispatched = UINT64_MAX;
+        uint64_t bestSequential = UINT64_MAX;
+        for (uint8_t round = 0; round < ROUNDS; round++) {
+            uint64_t start = nanos();
+            for (uint16_t i = 0; i < REPEATS; i++) {
+                dispatchFrame(&IR_defaultReceiver, &results);
+            }
+            uint64_t each = (nanos() - start) / REPEATS;
+            if (each < bestDispatched) {
+                bestDispatched = each;
+            }
+
+            start = nanos();
+            for (uint16_t i = 0; i < REPEATS; i++) {
+                decodeInTurn(&IR_defaultReceiver, &results);
+            }
+            each = (nanos() - start) / REPEATS;
+            if (each < bestSequential) {
+                bestSequential = each;
+            }
+        }
+        account(dispatched, bestDispatched);
+        account(sequential, bestSequential);
+
+        bool decoded = dispatchFrame(&IR_defaultReceiver, &results);
+        ir_decode_type_t type = results.decode_type;
+        CHECK_EQUAL(decoded, decodeInTurn(&IR_defaultReceiver, &results));
+        CHECK(!decoded || results.decode_type == type);
+        IR_resume();
+    }
+}
+
+int main(void) {
+    frame_t frame;
+
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_mockSpace(FRAME_GAP);
+
+    printf("%-12s %21s %21s\n", "ns/frame", "dispatch avg worst", "in turn avg worst");
+    for (uint8_t p = 0; p <= PROTOCOLS; p++) {
+        cost_t dispatched = { 0, 0 };
+        cost_t sequential = { 0, 0 };
+        measure(p, &dispatched, &sequential);
+        printf("%-12s %10lu %10lu %10lu %10lu\n", p < PROTOCOLS ? protocols[p].name : "random",
+                (unsigned long)(dispatched.total / VARIANTS), (unsigned long)dispatched.worst,
+                (unsigned long)(sequential.total / VARIANTS), (unsigned long)sequential.worst);
+    }
+
+    // Truncated frames, the random ones and again with a short gap
+    for (uint8_t p = 0; p < PROTOCOLS; p++) {
+        generate(&frame, p, 0);
+        for (uint16_t length = frame.length; length > 1; length--) {
+            frame.length = length;
+            checkSignatures(&frame);
+            frame.durations[0] = 300;
+            checkSignatures(&frame);
+            frame.durations[0] = FRAME_GAP;
+        }
+    }
+    for (uint32_t i = 0; i < RANDOM_FRAMES; i++) {
+        generateRandom(&frame);
+        checkSignatures(&frame);
+    }
+
+    for (uint8_t d = 0; d < DECODERS; d++) {
+        // Sharp reads its data bits from the wrong offset and never accepts a frame
+        if (accepted[d] == 0) {
+            printf("decode type %d accepted no frame, its signatures are unchecked\n", decoders[d]->decode_type);
+        }
+    }
+    printf("signatures: %lu violations\n", (unsigned long)violations);
+    CHECK_EQUAL(0, violations);
+    return TEST_RESULT();
+}
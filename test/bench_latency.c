@@ -0,0 +1,85 @@
+/**
+ * @file bench_latency.c
+ * @brief Time from the last edge of a frame to its hand over, with the full and a narrowed protocol set.
+ *
+ * Built twice: bench_latency with USE_IR_EARLY_FRAME_END, bench_latency_gap without it.
+ * JVC always waits for the gap while NEC is enabled, its header is within the tolerance of NEC.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static uint32_t committed;
+
+static void frameCommitted(ir_receiver_t *receiver) {
+    (void)receiver;
+    committed = IR_mockMicros();
+}
+
+static void sendNEC(void) {
+    IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, 0x20DF10EF);
+}
+
+static void sendNECRepeat(void) {
+    IR_mockMark(9000);
+    IR_mockSpace(2250);
+    IR_mockMark(560);
+}
+
+static void sendSamsung(void) {
+    IR_mockPulseDistance32(4500, 4500, 560, 1690, 560, 32, 0xE0E040BF);
+}
+
+static void sendJVC(void) {
+    IR_mockPulseDistance32(8400, 4200, 525, 1575, 525, 16, 0xC5E8);
+}
+
+static const struct {
+    const char *name;
+    void (*send)(void);
+} frames[] = {
+    { "NEC", sendNEC },
+    { "NEC repeat", sendNECRepeat },
+    { "Samsung", sendSamsung },
+    { "JVC", sendJVC },
+};
+
+#define FRAMES  (sizeof(frames) / sizeof(frames[0]))
+
+// Latency of each frame in us, 0 if it was not decoded
+static void measure(const char *set, ir_protocol_mask_t protocols) {
+    ir_decode_results results;
+
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_setProtocols(protocols);
+    IR_setFrameCallback(frameCommitted);
+    IR_mockSpace(20000);
+
+    printf("%-12s", set);
+    for (uint8_t i = 0; i < FRAMES; i++) {
+        committed = 0;
+        frames[i].send();
+        uint32_t lastEdge = IR_mockMicros();
+        IR_mockSpace(40000);
+        bool decoded = IR_decode(&results);
+        CHECK(decoded);
+        if (decoded) {
+            IR_resume();
+        }
+        printf(" %s %5lu us", frames[i].name, decoded ? (unsigned long)(committed - lastEdge) : 0UL);
+    }
+    printf("\n");
+    IR_setFrameCallback(NULL);
+}
+
+int main(void) {
+#ifdef USE_IR_EARLY_FRAME_END
+    printf("USE_IR_EARLY_FRAME_END\n");
+#else
+    printf("end of frame by the gap\n");
+#endif
+    measure("all", IR_PROTOCOLS_ALL);
+    measure("pulse dist.", IR_PROTOCOL_BIT(NEC) | IR_PROTOCOL_BIT(SAMSUNG) | IR_PROTOCOL_BIT(JVC));
+    return TEST_RESULT();
+}
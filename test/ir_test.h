@@ -0,0 +1,37 @@
+/**
+ * @file ir_test.h
+ * @brief Checks of the host tests. A test binary returns the number of failed checks.
+ */
+#ifndef IR_TEST_H
+#define IR_TEST_H
+
+#include <stdio.h>
+
+static int IR_testFailures;
+
+#define CHECK(condition) do { \
+        if (!(condition)) { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            IR_testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+        unsigned long expected_ = (unsigned long)(expected); \
+        unsigned long actual_ = (unsigned long)(actual); \
+        if (expected_ != actual_) { \
+            printf("%s:%d: check failed: %s == %s (0x%lX != 0x%lX)\n", __FILE__, __LINE__, \
+                    #expected, #actual, expected_, actual_); \
+            IR_testFailures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(test) do { \
+        int failures_ = IR_testFailures; \
+        test(); \
+        printf("%-40s %s\n", #test, IR_testFailures == failures_ ? "ok" : "FAILED"); \
+    } while (0)
+
+#define TEST_RESULT() (IR_testFailures != 0)
+
+#endif // IR_TEST_H
@@ -0,0 +1,28 @@
+/**
+ * @file cmsis_os.h
+ * @brief Host mock of the CMSIS-RTOS calls used by the library, the kernel tick is the simulated time in ms.
+ */
+#ifndef IR_MOCK_CMSIS_OS_H
+#define IR_MOCK_CMSIS_OS_H
+
+#include <stdint.h>
+
+typedef void *osThreadId;
+typedef int osStatus;
+
+typedef struct {
+    osStatus status;
+    union {
+        uint32_t v;
+        int32_t signals;
+    } value;
+} osEvent;
+
+#define osWaitForever   0xFFFFFFFFu
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals);
+osEvent osSignalWait(int32_t signals, uint32_t millisec);
+uint32_t osKernelSysTick(void);
+osStatus osDelay(uint32_t millisec);
+
+#endif // IR_MOCK_CMSIS_OS_H
@@ -0,0 +1,3 @@
+#include <stdint.h>
+
+void delay_us(uint32_t us);
@@ -0,0 +1,102 @@
+/**
+ * @file gpio.h
+ * @brief Host mock of the STM32 LL timer, DMA and GPIO calls used by the library.
+ *
+ * The registers are plain structs, ir_mock.c moves them along with the simulated
+ * time and calls the IRQ handlers whenever an enabled flag is set.
+ */
+#ifndef IR_MOCK_GPIO_H
+#define IR_MOCK_GPIO_H
+
+#include <stdint.h>
+
+typedef int IRQn_Type;
+
+typedef struct {
+    uint32_t CNT;
+    uint32_t ARR;
+    uint32_t CCR1;
+    uint32_t CCR2;
+    uint32_t CCR3;
+    uint32_t SR;                    ///< TIM_SR_* flags
+    uint32_t DIER;                  ///< Enabled interrupts, same bits as SR
+} TIM_TypeDef;
+
+typedef struct {
+    uint16_t *buffer;               ///< Circular destination of the CH2 captures
+    uint16_t length;
+    uint16_t CNDTR;                 ///< Remaining transfers until the buffer wraps
+    uint32_t ISR;                   ///< DMA_ISR_* flags
+} DMA_TypeDef;
+
+typedef struct {
+    uint32_t IDR;
+} GPIO_TypeDef;
+
+#define TIM_SR_UIF      0x01u
+#define TIM_SR_CC1IF    0x02u
+#define TIM_SR_CC2IF    0x04u
+#define TIM_SR_CC3IF    0x08u
+
+#define DMA_ISR_HTIF    0x01u
+#define DMA_ISR_TCIF    0x02u
+
+extern TIM_TypeDef IR_mockTim2;
+extern DMA_TypeDef IR_mockDma1;
+extern GPIO_TypeDef IR_mockGpioA;
+extern GPIO_TypeDef IR_mockGpioC;
+
+#define TIM2                    (&IR_mockTim2)
+#define DMA1                    (&IR_mockDma1)
+#define GPIOA                   (&IR_mockGpioA)
+#define GPIOC                   (&IR_mockGpioC)
+
+#define TIM2_IRQn               15
+#define DMA1_Channel2_3_IRQn    10
+
+#define LL_GPIO_PIN_1           0x0002u
+#define LL_GPIO_PIN_2           0x0004u
+#define LL_GPIO_AF_2            2u
+#define LL_TIM_CHANNEL_CH1      0x0001u
+#define LL_TIM_IC_FILTER_FDIV1  0u
+#define LL_DMA_CHANNEL_3        3u
+#define LL_DMA_REQUEST_8        8u
+
+#define __CORTEX_M              0
+#define __DMB()                 __asm__ volatile("" ::: "memory")
+
+// The simulated interrupts run synchronously, nothing to mask
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) { }
+
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+
+static inline uint32_t LL_TIM_GetCounter(TIM_TypeDef *TIMx) { return TIMx->CNT; }
+static inline void LL_TIM_SetCounter(TIM_TypeDef *TIMx, uint32_t counter) { TIMx->CNT = counter; }
+static inline uint32_t LL_TIM_IC_GetCaptureCH1(TIM_TypeDef *TIMx) { return TIMx->CCR1; }
+static inline uint32_t LL_TIM_IC_GetCaptureCH2(TIM_TypeDef *TIMx) { return TIMx->CCR2; }
+static inline void LL_TIM_OC_SetCompareCH3(TIM_TypeDef *TIMx, uint32_t value) { TIMx->CCR3 = value; }
+static inline void LL_TIM_CC_EnableChannel(TIM_TypeDef *TIMx, uint32_t channels) { (void)TIMx; (void)channels; }
+static inline void LL_TIM_CC_DisableChannel(TIM_TypeDef *TIMx, uint32_t channels) { (void)TIMx; (void)channels; }
+
+#define IR_MOCK_TIM_FLAG(name, bit) \
+    static inline uint32_t LL_TIM_IsActiveFlag_##name(TIM_TypeDef *TIMx) { return (TIMx->SR & (bit)) != 0; } \
+    static inline void LL_TIM_ClearFlag_##name(TIM_TypeDef *TIMx) { TIMx->SR &= ~(bit); } \
+    static inline void LL_TIM_EnableIT_##name(TIM_TypeDef *TIMx) { TIMx->DIER |= (bit); } \
+    static inline void LL_TIM_DisableIT_##name(TIM_TypeDef *TIMx) { TIMx->DIER &= ~(bit); } \
+    static inline uint32_t LL_TIM_IsEnabledIT_##name(TIM_TypeDef *TIMx) { return (TIMx->DIER & (bit)) != 0; }
+IR_MOCK_TIM_FLAG(UPDATE, TIM_SR_UIF)
+IR_MOCK_TIM_FLAG(CC1, TIM_SR_CC1IF)
+IR_MOCK_TIM_FLAG(CC2, TIM_SR_CC2IF)
+IR_MOCK_TIM_FLAG(CC3, TIM_SR_CC3IF)
+#undef IR_MOCK_TIM_FLAG
+
+static inline uint32_t LL_DMA_GetDataLength(DMA_TypeDef *DMAx, uint32_t channel) { (void)channel; return DMAx->CNDTR; }
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *GPIOx, uint32_t pin) { return (GPIOx->IDR & pin) != 0; }
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx, uint32_t pin) { (void)GPIOx; (void)pin; }
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx, uint32_t pin) { (void)GPIOx; (void)pin; }
+
+#endif // IR_MOCK_GPIO_H
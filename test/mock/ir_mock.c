@@ -0,0 +1,246 @@
+/**
+ * @file ir_mock.c
+ * @brief Simulated capture timer, DMA and RTOS of the host tests, see ir_mock.h.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+
+TIM_TypeDef IR_mockTim2;
+DMA_TypeDef IR_mockDma1;
+GPIO_TypeDef IR_mockGpioA;
+GPIO_TypeDef IR_mockGpioC;
+uint32_t IR_mockStuckIRQs;
+
+static uint32_t now;
+static bool timerIrqEnabled;
+static bool dmaIrqEnabled;
+static bool masked;
+static bool inIrq;
+
+//+=============================================================================
+// Board and RTOS functions the application supplies on the target
+//
+void IR_timerConfigForReceive(const ir_receiver_hw_t *hw) {
+    TIM_TypeDef *TIMx = hw->tim;
+
+    TIMx->SR = 0;
+    TIMx->CCR3 = 0;
+#if defined(USE_TIMER_DMA_MODE)
+    TIMx->ARR = 0xFFFF;
+    TIMx->DIER = TIM_SR_CC2IF;
+#elif defined(USE_TIMER_IC_FREE_RUNNING)
+    TIMx->ARR = 0xFFFF;
+    TIMx->DIER = TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF;
+#else
+    TIMx->ARR = 10000 - 1;
+    TIMx->DIER = TIM_SR_CC1IF | TIM_SR_CC2IF;
+#endif
+}
+
+void IR_timerConfigForSend(uint16_t aFrequencyKHz) {
+    (void)aFrequencyKHz;
+}
+
+#ifdef USE_TIMER_DMA_MODE
+void IR_dmaConfigForReceive(const ir_receiver_hw_t *hw, uint16_t *aTimestamps, uint16_t aLength) {
+    hw->dma->buffer = aTimestamps;
+    hw->dma->length = aLength;
+    hw->dma->CNDTR = aLength;
+    hw->dma->ISR = 0;
+    dmaIrqEnabled = true;
+}
+
+void IR_dmaClearFlags(const ir_receiver_hw_t *hw) {
+    hw->dma->ISR = 0;
+}
+#endif
+
+void NVIC_EnableIRQ(IRQn_Type irqn) {
+    if (irqn == TIM2_IRQn) {
+        timerIrqEnabled = true;
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn) {
+    if (irqn == TIM2_IRQn) {
+        timerIrqEnabled = false;
+    } else if (irqn == DMA1_Channel2_3_IRQn) {
+        dmaIrqEnabled = false;
+    }
+}
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals) {
+    (void)thread_id;
+    return signals;
+}
+
+osEvent osSignalWait(int32_t signals, uint32_t millisec) {
+    osEvent event = { 0 };
+    (void)millisec;
+    event.value.signals = signals;
+    return event;
+}
+
+uint32_t osKernelSysTick(void) {
+    return now / 1000;
+}
+
+osStatus osDelay(uint32_t millisec) {
+    IR_mockRun(millisec * 1000);
+    return 0;
+}
+
+void delay_us(uint32_t us) {
+    (void)us;
+}
+
+//+=============================================================================
+// Simulation
+//
+static void dispatch(void) {
+    if (inIrq || masked) {
+        return;
+    }
+    inIrq = true;
+    for (uint8_t rounds = 0; ; rounds++) {
+        bool timerPending = timerIrqEnabled && (IR_mockTim2.SR & IR_mockTim2.DIER);
+        bool dmaPending = dmaIrqEnabled && IR_mockDma1.ISR;
+        if (!timerPending && !dmaPending) {
+            break;
+        }
+        if (rounds == 8) {
+            // The handler does not clear its flag, the target would hang here
+            IR_mockStuckIRQs++;
+            IR_mockTim2.SR &= ~IR_mockTim2.DIER;
+            IR_mockDma1.ISR = 0;
+            break;
+        }
+        if (timerPending) {
+            IR_TimerIRQHandler();
+        }
+#ifdef USE_TIMER_DMA_MODE
+        if (dmaPending) {
+            IR_DMAIRQHandler();
+        }
+#endif
+    }
+    inIrq = false;
+}
+
+static void capture(bool falling) {
+    TIM_TypeDef *TIMx = &IR_mockTim2;
+
+#ifdef USE_TIMER_DMA_MODE
+    // CH2 captures both edges, every capture is moved into the circular buffer
+    DMA_TypeDef *dma = &IR_mockDma1;
+    (void)falling;
+    TIMx->CCR2 = TIMx->CNT;
+    TIMx->SR |= TIM_SR_CC2IF;
+    if (dma->buffer) {
+        dma->buffer[dma->length - dma->CNDTR] = TIMx->CNT;
+        if (--dma->CNDTR == dma->length / 2) {
+            dma->ISR |= DMA_ISR_HTIF;
+        } else if (dma->CNDTR == 0) {
+            dma->ISR |= DMA_ISR_TCIF;
+            dma->CNDTR = dma->length;
+        }
+    }
+#else
+    // CH1 captures the falling, CH2 the rising edges of the same input
+    if (falling) {
+        TIMx->CCR1 = TIMx->CNT;
+        TIMx->SR |= TIM_SR_CC1IF;
+    } else {
+        TIMx->CCR2 = TIMx->CNT;
+        TIMx->SR |= TIM_SR_CC2IF;
+    }
+#endif
+}
+
+void IR_mockSetInput(uint8_t level) {
+    bool high = level == SPACE;
+    bool wasHigh = (IR_mockGpioA.IDR & IRRECEIVE_Pin) != 0;
+
+    if (high == wasHigh) {
+        return;
+    }
+    if (high) {
+        IR_mockGpioA.IDR |= IRRECEIVE_Pin;
+    } else {
+        IR_mockGpioA.IDR &= ~IRRECEIVE_Pin;
+    }
+    capture(!high);
+    dispatch();
+}
+
+void IR_mockReset(uint16_t counter) {
+    memset(&IR_mockTim2, 0, sizeof(IR_mockTim2));
+    memset(&IR_mockDma1, 0, sizeof(IR_mockDma1));
+    IR_mockTim2.CNT = counter;
+    IR_mockGpioA.IDR = IRRECEIVE_Pin;
+    IR_mockStuckIRQs = 0;
+    now = 0;
+    masked = false;
+}
+
+uint32_t IR_mockMicros(void) {
+    return now;
+}
+
+void IR_mockRun(uint32_t us) {
+    TIM_TypeDef *TIMx = &IR_mockTim2;
+
+    while (us--) {
+        now++;
+        if (TIMx->CNT >= TIMx->ARR) {
+            TIMx->CNT = 0;
+            TIMx->SR |= TIM_SR_UIF;
+        } else {
+            TIMx->CNT++;
+        }
+        if (TIMx->CNT == TIMx->CCR3) {
+            TIMx->SR |= TIM_SR_CC3IF;
+        }
+        dispatch();
+    }
+}
+
+void IR_mockMark(uint32_t us) {
+    IR_mockSetInput(MARK);
+    IR_mockRun(us);
+    IR_mockSetInput(SPACE);
+}
+
+void IR_mockSpace(uint32_t us) {
+    IR_mockSetInput(SPACE);
+    IR_mockRun(us);
+}
+
+void IR_mockMaskIRQs(bool mask) {
+    masked = mask;
+    dispatch();
+}
+
+void IR_mockPulseDistance(uint16_t headerMark, uint16_t headerSpace, uint16_t bitMark,
+        uint16_t oneSpace, uint16_t zeroSpace, uint16_t bits, const uint8_t *data) {
+    if (headerMark) {
+        IR_mockMark(headerMark);
+        IR_mockSpace(headerSpace);
+    }
+    for (uint16_t i = 0; i < bits; i++) {
+        IR_mockMark(bitMark);
+        IR_mockSpace(data[i / 8] & (0x80 >> (i % 8)) ? oneSpace : zeroSpace);
+    }
+    IR_mockMark(bitMark);
+}
+
+void IR_mockPulseDistance32(uint16_t headerMark, uint16_t headerSpace, uint16_t bitMark,
+        uint16_t oneSpace, uint16_t zeroSpace, uint8_t bits, uint32_t value) {
+    uint8_t data[4];
+
+    value <<= 32 - bits;
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = value >> (24 - 8 * i);
+    }
+    IR_mockPulseDistance(headerMark, headerSpace, bitMark, oneSpace, zeroSpace, bits, data);
+}
@@ -0,0 +1,47 @@
+/**
+ * @file ir_mock.h
+ * @brief Simulated receiver input for the host tests.
+ *
+ * Time advances in steps of 1 us. The capture timer of the default receiver counts
+ * along, captures the edges of the input like the hardware of the configured receive
+ * mode does and the IRQ handlers run as soon as an enabled flag is set.
+ */
+#ifndef IR_MOCK_H
+#define IR_MOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Start over at time 0 with an idle input and the capture counter at counter */
+void IR_mockReset(uint16_t counter);
+
+/** Simulated time in us */
+uint32_t IR_mockMicros(void);
+
+/** Set the input to MARK or SPACE */
+void IR_mockSetInput(uint8_t level);
+
+/** Keep the input as it is for us */
+void IR_mockRun(uint32_t us);
+
+/** Input low (mark) for us, then high again */
+void IR_mockMark(uint32_t us);
+
+/** Input high (space) for us */
+void IR_mockSpace(uint32_t us);
+
+/** Hold the IRQs back, like a higher priority IRQ would. They run once unmasked. */
+void IR_mockMaskIRQs(bool masked);
+
+/** Marks and spaces of a pulse distance frame, MSB first, ending with the stop mark */
+void IR_mockPulseDistance(uint16_t headerMark, uint16_t headerSpace, uint16_t bitMark,
+        uint16_t oneSpace, uint16_t zeroSpace, uint16_t bits, const uint8_t *data);
+
+/** IR_mockPulseDistance() of up to 32 bits */
+void IR_mockPulseDistance32(uint16_t headerMark, uint16_t headerSpace, uint16_t bitMark,
+        uint16_t oneSpace, uint16_t zeroSpace, uint8_t bits, uint32_t value);
+
+/** Number of times a handler returned with its own flag still set */
+extern uint32_t IR_mockStuckIRQs;
+
+#endif // IR_MOCK_H
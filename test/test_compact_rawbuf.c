@@ -0,0 +1,69 @@
+/**
+ * @file test_compact_rawbuf.c
+ * @brief USE_IR_COMPACT_RAWBUF: frames with more long durations than rawlong slots are not decoded.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+// Longer than a compact entry holds, shorter than the timer overflow ending a frame
+#define LONG_MARK   (IR_COMPACT_LONG_BASE * IR_COMPACT_MICROS + 500)
+
+static void start(void) {
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_mockSpace(20000);
+}
+
+// A frame of longMarks long and 4 short marks
+static void sendFrame(uint8_t longMarks) {
+    for (uint8_t i = 0; i < longMarks; i++) {
+        IR_mockMark(LONG_MARK);
+        IR_mockSpace(600);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        IR_mockMark(600);
+        IR_mockSpace(1200);
+    }
+    IR_mockMark(600);
+    IR_mockSpace(30000);
+}
+
+// Long marks which fit the rawlong slots next to the gap are read back exactly
+static void testLongDurations(void) {
+    start();
+    sendFrame(IR_COMPACT_LONG_LENGTH - 1);
+    if (!IR_decode(&results)) {
+        CHECK(!"frame received");
+        return;
+    }
+    CHECK(!results.overflow);
+    for (uint8_t i = 0; i < IR_COMPACT_LONG_LENGTH - 1; i++) {
+        CHECK_EQUAL(LONG_MARK / MICROS_PER_TICK, IR_RAW(&results, 1 + 2 * i));
+    }
+    IR_resume();
+}
+
+// More long marks than there are slots, the frame is dropped and counted
+static void testClipped(void) {
+    ir_receiver_stats_t stats;
+
+    start();
+    sendFrame(IR_COMPACT_LONG_LENGTH + 1);
+    CHECK(!IR_decode(&results));
+    IR_getStats(&stats);
+    CHECK_EQUAL(1, stats.frames);
+    CHECK_EQUAL(1, stats.overflows);
+    CHECK_EQUAL(1, stats.unknown);
+
+    sendFrame(IR_COMPACT_LONG_LENGTH + 1);
+    CHECK(!IR_available(&results));
+}
+
+int main(void) {
+    RUN_TEST(testLongDurations);
+    RUN_TEST(testClipped);
+    return TEST_RESULT();
+}
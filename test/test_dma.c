@@ -0,0 +1,182 @@
+/**
+ * @file test_dma.c
+ * @brief USE_TIMER_DMA_MODE: conversion of the captured timestamps and segmentation into frames.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+static void sendNEC(uint32_t value) {
+    IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, value);
+}
+
+static void sendNECRepeat(void) {
+    IR_mockMark(9000);
+    IR_mockSpace(2250);
+    IR_mockMark(560);
+}
+
+static void start(uint16_t counter) {
+    IR_mockReset(counter);
+    IR_enableIRIn();
+    IR_mockSpace(20000);
+}
+
+// Decodes the next frame, the type is 0 if there is none
+static ir_decode_type_t decodeNext(void) {
+    memset(&results, 0, sizeof(results));
+    if (!IR_decode(&results)) {
+        return 0;
+    }
+    IR_resume();
+    return results.decode_type;
+}
+
+// Every duration of a frame arrives exactly, across the wrap of the 16 bit timestamps
+// and of the circular DMA buffer (an NEC frame has 68 edges)
+static void testConversion(void) {
+    static const uint16_t counters[] = { 0, 0xC000, 0xFFF0 };
+
+    for (uint8_t k = 0; k < sizeof(counters) / sizeof(counters[0]); k++) {
+        start(counters[k]);
+        sendNEC(0x20DF10EF);
+        IR_mockSpace(20000);
+
+        ir_receiver_stats_t stats;
+        if (!IR_decode(&results)) {
+            CHECK(!"frame received");
+            continue;
+        }
+        CHECK_EQUAL(68, results.rawlen);
+        CHECK_EQUAL(9000, IR_RAW(&results, 1));
+        CHECK_EQUAL(4500, IR_RAW(&results, 2));
+        for (uint8_t i = 0; i < 32; i++) {
+            CHECK_EQUAL(560, IR_RAW(&results, 3 + 2 * i));
+            CHECK_EQUAL(0x20DF10EF & (0x80000000UL >> i) ? 1690 : 560, IR_RAW(&results, 4 + 2 * i));
+        }
+        CHECK_EQUAL(560, IR_RAW(&results, 67));
+        CHECK_EQUAL(NEC, results.decode_type);
+        IR_resume();
+        IR_getStats(&stats);
+        CHECK_EQUAL(1, stats.frames);
+        CHECK_EQUAL(0, IR_mockStuckIRQs);
+    }
+}
+
+// Headers longer than _GAP must not end the frame
+static void testLongMarks(void) {
+    start(0);
+    sendNEC(0x20DF10EF);
+    IR_mockSpace(40000);
+    sendNECRepeat();
+    IR_mockSpace(96000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK_EQUAL(0x20DF10EF, results.value);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK(results.isRepeat);
+
+    IR_mockPulseDistance32(8000, 4000, 550, 1600, 550, 28, 0x880094D); // LG
+    IR_mockSpace(20000);
+    CHECK_EQUAL(LG, decodeNext());
+    CHECK_EQUAL(0x880094D, results.value);
+
+    IR_mockPulseDistance32(8400, 4200, 525, 1575, 525, 16, 0xC5E8); // JVC
+    IR_mockSpace(20000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK_EQUAL(0xC5E8, results.value);
+
+    IR_mockPulseDistance32(4500, 4500, 560, 1690, 560, 32, 0xE0E040BF); // Samsung
+    IR_mockSpace(20000);
+    CHECK_EQUAL(SAMSUNG, decodeNext());
+    CHECK_EQUAL(0xE0E040BF, results.value);
+    CHECK_EQUAL(0, decodeNext());
+}
+
+// Frames which arrive while the IRQs are held back are cut apart at their gaps,
+// a 9 ms mark in the same batch is no gap
+static void testSegmentation(void) {
+    ir_receiver_stats_t stats;
+
+    start(0);
+    IR_mockMaskIRQs(true);
+    sendNECRepeat();
+    IR_mockSpace(30000);
+    sendNECRepeat();
+    IR_mockSpace(30000);
+    IR_mockMaskIRQs(false);
+
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK(results.isRepeat);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK(results.isRepeat);
+    CHECK_EQUAL(0, decodeNext());
+    IR_getStats(&stats);
+    CHECK_EQUAL(2, stats.frames);
+    CHECK_EQUAL(8, stats.edges);
+}
+
+// While the ring is full frames are dropped as a whole, even if the ring
+// is released in the middle of a long mark
+static void testDropWhileFull(void) {
+    ir_receiver_stats_t stats;
+
+    start(0);
+    for (uint8_t i = 0; i < IR_FRAME_RING_LENGTH; i++) {
+        sendNECRepeat();
+        IR_mockSpace(30000);
+    }
+    // Release the ring 7 ms into the header of a dropped frame
+    IR_mockSetInput(MARK);
+    IR_mockRun(7000);
+    for (uint8_t i = 0; i < IR_FRAME_RING_LENGTH; i++) {
+        CHECK_EQUAL(NEC, decodeNext());
+    }
+    IR_mockRun(2000);
+    IR_mockSpace(4500);
+    IR_mockPulseDistance32(0, 0, 560, 1690, 560, 32, 0x12345678);
+    IR_mockSpace(30000);
+    CHECK_EQUAL(0, decodeNext());
+
+    sendNEC(0x20DF10EF);
+    IR_mockSpace(30000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK_EQUAL(0x20DF10EF, results.value);
+    IR_getStats(&stats);
+    CHECK_EQUAL(1, stats.dropped);
+    CHECK_EQUAL(IR_FRAME_RING_LENGTH + 1, stats.frames);
+}
+
+// The gap in front of a frame is exact below a full timer period and clipped to 0xFFFF above,
+// instead of wrapping around with the 16 bit timestamps
+static void testLongGap(void) {
+    static const uint32_t gaps[] = { 50000, 70000, 140000, 50000 };
+    static const uint16_t expected[] = { 50000, 0xFFFF, 0xFFFF, 50000 };
+
+    start(0x1234);
+    sendNECRepeat();
+    IR_mockSpace(20000);
+    CHECK_EQUAL(NEC, decodeNext());
+    for (uint8_t k = 0; k < sizeof(gaps) / sizeof(gaps[0]); k++) {
+        IR_mockSpace(gaps[k] - 20000);
+        sendNECRepeat();
+        IR_mockSpace(20000);
+        if (!IR_decode(&results)) {
+            CHECK(!"frame received");
+            continue;
+        }
+        CHECK_EQUAL(expected[k], IR_RAW(&results, 0));
+        IR_resume();
+    }
+    CHECK_EQUAL(0, IR_mockStuckIRQs);
+}
+
+int main(void) {
+    RUN_TEST(testConversion);
+    RUN_TEST(testLongMarks);
+    RUN_TEST(testSegmentation);
+    RUN_TEST(testDropWhileFull);
+    RUN_TEST(testLongGap);
+    return TEST_RESULT();
+}
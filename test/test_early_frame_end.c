@@ -0,0 +1,130 @@
+/**
+ * @file test_early_frame_end.c
+ * @brief USE_IR_EARLY_FRAME_END: frames are only handed over before the gap when they cannot grow.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+static void sendNEC(uint32_t value) {
+    IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, value);
+}
+
+// 50 bits MSB first and the footer mark, see IR_sendMagiQuest()
+static void sendMagiQuest(uint64_t bits) {
+    for (uint64_t mask = 1ULL << 49; mask != 0; mask >>= 1) {
+        if (bits & mask) {
+            IR_mockMark(575);
+            IR_mockSpace(575);
+        } else {
+            IR_mockMark(288);
+            IR_mockSpace(862);
+        }
+    }
+    IR_mockMark(288);
+}
+
+static void start(ir_protocol_mask_t protocols) {
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_setProtocols(protocols);
+    IR_mockSpace(20000);
+}
+
+// Decodes the next frame, the type is 0 if there is none
+static ir_decode_type_t decodeNext(void) {
+    memset(&results, 0, sizeof(results));
+    if (!IR_decode(&results)) {
+        return 0;
+    }
+    IR_resume();
+    return results.decode_type;
+}
+
+// NEC and its repeat are handed over with their stop mark once nothing else could take them
+static void testEarlyNEC(void) {
+    start(IR_PROTOCOL_BIT(NEC) | IR_PROTOCOL_BIT(SAMSUNG));
+    sendNEC(0x20DF10EF);
+    IR_mockSpace(1000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK_EQUAL(0x20DF10EF, results.value);
+
+    IR_mockSpace(40000);
+    IR_mockMark(9000);
+    IR_mockSpace(2250);
+    IR_mockMark(560);
+    IR_mockSpace(1000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK(results.isRepeat);
+    IR_mockSpace(20000);
+    CHECK_EQUAL(0, decodeNext());
+}
+
+// Sony takes frames of any first mark from 26 entries on, so a NEC repeat waits for the gap
+static void testRepeatWaits(void) {
+    start(IR_PROTOCOL_BIT(NEC) | IR_PROTOCOL_BIT(SONY));
+    IR_mockMark(9000);
+    IR_mockSpace(2250);
+    IR_mockMark(560);
+    IR_mockSpace(1000);
+    CHECK_EQUAL(0, decodeNext());
+    IR_mockSpace(20000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK(results.isRepeat);
+}
+
+// A frame of the right length whose durations do not all match waits for the gap
+static void testMismatchWaits(void) {
+    ir_receiver_stats_t stats;
+
+    start(IR_PROTOCOL_BIT(NEC));
+    IR_mockMark(9000);
+    IR_mockSpace(4500);
+    IR_mockPulseDistance32(0, 0, 560, 3000, 560, 32, 0x00010000);
+    IR_mockSpace(1000);
+    IR_getStats(&stats);
+    CHECK_EQUAL(0, stats.frames);
+    IR_mockSpace(20000);
+    IR_getStats(&stats);
+    CHECK_EQUAL(1, stats.frames);
+    CHECK_EQUAL(0, decodeNext());
+}
+
+// MagiQuest starts like Denon and its leading zeros fit Denon bits, it must not be cut.
+// Sony and Sanyo are left out, the gap before a frame is not measured in input capture
+// mode and they take any frame after a short gap for a repeat.
+static void testMagiQuestNotCut(void) {
+    ir_receiver_stats_t stats;
+
+    start(IR_PROTOCOLS_ALL & ~(IR_PROTOCOL_BIT(SONY) | IR_PROTOCOL_BIT(SANYO)));
+    sendMagiQuest(0x00001234ABCDULL);
+    IR_mockSpace(1000);
+    CHECK_EQUAL(0, decodeNext());
+    IR_mockSpace(20000);
+    CHECK_EQUAL(MAGIQUEST, decodeNext());
+    CHECK_EQUAL(0, decodeNext());
+    IR_getStats(&stats);
+    CHECK_EQUAL(1, stats.frames);
+}
+
+// With all protocols enabled MagiQuest could take a longer frame with a NEC header
+static void testDefaultWaits(void) {
+    start(IR_PROTOCOLS_ALL);
+    sendNEC(0x20DF10EF);
+    IR_mockSpace(1000);
+    CHECK_EQUAL(0, decodeNext());
+    IR_mockSpace(20000);
+    CHECK_EQUAL(NEC, decodeNext());
+    CHECK_EQUAL(0x20DF10EF, results.value);
+}
+
+int main(void) {
+    RUN_TEST(testEarlyNEC);
+    RUN_TEST(testRepeatWaits);
+    RUN_TEST(testMismatchWaits);
+    RUN_TEST(testMagiQuestNotCut);
+    RUN_TEST(testDefaultWaits);
+    return TEST_RESULT();
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test_edge_fifo.c
+ * @brief USE_IR_EDGE_FIFO: frames lost to a FIFO overrun are counted, IR_framePending() sees queued edges.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+static void sendNECRepeat(void) {
+    IR_mockMark(9000);
+    IR_mockSpace(2250);
+    IR_mockMark(560);
+    IR_mockSpace(40000);
+}
+
+static void start(void) {
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_mockSpace(20000);
+}
+
+static uint16_t decodeAll(void) {
+    uint16_t decoded = 0;
+
+    while (IR_decode(&results)) {
+        decoded++;
+        IR_resume();
+    }
+    return decoded;
+}
+
+static void testNoOverrun(void) {
+    ir_receiver_stats_t stats;
+
+    start();
+    for (uint8_t i = 0; i < 4; i++) {
+        sendNECRepeat();
+    }
+    CHECK_EQUAL(4, decodeAll());
+    IR_getStats(&stats);
+    CHECK_EQUAL(4, stats.frames);
+    CHECK_EQUAL(0, stats.overruns);
+}
+
+// A NEC repeat takes 5 entries, the FIFO runs over in the middle of the 13th.
+// That frame loses its end marker, the next frame start finds it unfinished.
+static void testOverrunLosesEnd(void) {
+    ir_receiver_stats_t stats;
+
+    start();
+    for (uint8_t i = 0; i < 20; i++) {
+        sendNECRepeat();
+    }
+    CHECK_EQUAL(IR_EDGE_FIFO_LENGTH / 5, decodeAll());
+    sendNECRepeat();
+    CHECK_EQUAL(1, decodeAll());
+    IR_getStats(&stats);
+    CHECK_EQUAL(21, stats.frames);
+    CHECK_EQUAL(1, stats.overruns);
+    CHECK_EQUAL(1, IR_getDroppedFrames());
+}
+
+// IR_decode() returns false for the thrown away frame, the one behind it is still pending
+static void testPendingBehindRejected(void) {
+    start();
+    CHECK(!IR_framePending());
+    IR_mockMark(560);
+    IR_mockSpace(40000);
+    sendNECRepeat();
+    CHECK(IR_framePending());
+    CHECK(!IR_decode(&results));
+    CHECK(IR_framePending());
+    CHECK(IR_decode(&results));
+    CHECK_EQUAL(NEC, results.decode_type);
+    IR_resume();
+    CHECK(!IR_framePending());
+}
+
+int main(void) {
+    RUN_TEST(testNoOverrun);
+    RUN_TEST(testOverrunLosesEnd);
+    RUN_TEST(testPendingBehindRejected);
+    return TEST_RESULT();
+}
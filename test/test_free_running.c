@@ -0,0 +1,87 @@
+/**
+ * @file test_free_running.c
+ * @brief USE_TIMER_IC_FREE_RUNNING: only a space longer than _GAP ends a frame.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+static void start(uint16_t counter) {
+    IR_mockReset(counter);
+    IR_enableIRIn();
+    IR_mockSpace(20000);
+}
+
+// Decodes the next frame, the type is 0 if there is none
+static ir_decode_type_t decodeNext(void) {
+    memset(&results, 0, sizeof(results));
+    if (!IR_decode(&results)) {
+        return 0;
+    }
+    IR_resume();
+    return results.decode_type;
+}
+
+// Headers longer than _GAP must not end the frame, also across the counter overflow
+static void testLongMarks(void) {
+    static const uint16_t counters[] = { 0, 0xF000 };
+
+    for (uint8_t k = 0; k < sizeof(counters) / sizeof(counters[0]); k++) {
+        start(counters[k]);
+        IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, 0x20DF10EF); // NEC
+        IR_mockSpace(40000);
+        IR_mockMark(9000);
+        IR_mockSpace(2250);
+        IR_mockMark(560);
+        IR_mockSpace(96000);
+        CHECK_EQUAL(NEC, decodeNext());
+        CHECK_EQUAL(68, results.rawlen);
+        CHECK_EQUAL(0x20DF10EF, results.value);
+        CHECK_EQUAL(NEC, decodeNext());
+        CHECK(results.isRepeat);
+
+        IR_mockPulseDistance32(8000, 4000, 550, 1600, 550, 28, 0x880094D); // LG
+        IR_mockSpace(20000);
+        CHECK_EQUAL(LG, decodeNext());
+        CHECK_EQUAL(0x880094D, results.value);
+
+        IR_mockPulseDistance32(8400, 4200, 525, 1575, 525, 16, 0xC5E8); // JVC
+        IR_mockSpace(20000);
+        CHECK_EQUAL(JVC, decodeNext());
+        CHECK_EQUAL(0xC5E8, results.value);
+        CHECK_EQUAL(0, decodeNext());
+    }
+}
+
+// Spaces longer than _GAP split the frames, the gap is measured exactly
+static void testGaps(void) {
+    ir_receiver_stats_t stats;
+
+    start(0);
+    for (uint8_t i = 0; i < 3; i++) {
+        IR_mockMark(9000);
+        IR_mockSpace(2250);
+        IR_mockMark(560);
+        IR_mockSpace(30000);
+        if (!IR_decode(&results)) {
+            CHECK(!"frame received");
+            continue;
+        }
+        CHECK_EQUAL(4, results.rawlen);
+        CHECK_EQUAL((i == 0 ? 20000 : 30000) / MICROS_PER_TICK, IR_RAW(&results, 0));
+        CHECK_EQUAL(NEC, results.decode_type);
+        CHECK(results.isRepeat);
+        IR_resume();
+    }
+    CHECK_EQUAL(0, decodeNext());
+    IR_getStats(&stats);
+    CHECK_EQUAL(3, stats.frames);
+}
+
+int main(void) {
+    RUN_TEST(testLongMarks);
+    RUN_TEST(testGaps);
+    return TEST_RESULT();
+}
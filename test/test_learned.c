@@ -0,0 +1,209 @@
+/**
+ * @file test_learned.c
+ * @brief Learned codes: probing of the hash table and the length index of the templates.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+#define SLOTS 8
+
+static uint32_t hashes[SLOTS];
+static uint16_t actions[SLOTS];
+static const ir_learned_table_t table = { hashes, actions, SLOTS };
+
+static irraw_t rawbuf[RAW_BUFFER_LENGTH];
+static ir_decode_results results;
+
+static void clearTable(void) {
+    memset(hashes, 0, sizeof(hashes));
+    memset(actions, 0, sizeof(actions));
+}
+
+static uint16_t usedSlots(void) {
+    uint16_t used = 0;
+
+    for (uint16_t i = 0; i < SLOTS; i++) {
+        used += hashes[i] != IR_LEARNED_EMPTY;
+    }
+    return used;
+}
+
+// Returns the action of hash, IR_LEARNED_NONE if it is not in the table
+static uint16_t lookup(uint32_t hash) {
+    uint16_t action = IR_LEARNED_NONE;
+
+    if (!IR_learnedLookup(&table, hash, &action)) {
+        return IR_LEARNED_NONE;
+    }
+    return action;
+}
+
+// Lets results hold a frame of the given durations after the gap
+static void setFrame(const uint16_t *durations, uint16_t length) {
+    memset(&results, 0, sizeof(results));
+    results.rawbuf = rawbuf;
+    rawbuf[0] = 50000;
+    for (uint16_t i = 0; i < length; i++) {
+        rawbuf[i + 1] = durations[i];
+    }
+    results.rawlen = length + 1;
+}
+
+// Returns the action of the matching template, IR_LEARNED_NONE if none qualifies
+static uint16_t match(const ir_template_set_t *set) {
+    uint16_t action = IR_LEARNED_NONE;
+
+    if (!IR_templateMatch(set, &results, &action)) {
+        return IR_LEARNED_NONE;
+    }
+    return action;
+}
+
+// Hashes 7 and 15 both start at the last slot, 15 wraps around to slot 0
+static void testProbeWraparound(void) {
+    clearTable();
+    CHECK(IR_learnedInsert(hashes, actions, SLOTS, 7, 1));
+    CHECK(IR_learnedInsert(hashes, actions, SLOTS, 15, 2));
+    CHECK_EQUAL(7, hashes[SLOTS - 1]);
+    CHECK_EQUAL(15, hashes[0]);
+    CHECK_EQUAL(1, lookup(7));
+    CHECK_EQUAL(2, lookup(15));
+    CHECK_EQUAL(IR_LEARNED_NONE, lookup(23));
+}
+
+// A full table rejects another code, a lookup of a missing one stops after all slots
+static void testFullTable(void) {
+    clearTable();
+    for (uint32_t hash = 1; hash <= SLOTS; hash++) {
+        CHECK(IR_learnedInsert(hashes, actions, SLOTS, hash, hash + 100));
+    }
+    CHECK(!IR_learnedInsert(hashes, actions, SLOTS, SLOTS + 1, 1));
+    CHECK_EQUAL(IR_LEARNED_NONE, lookup(SLOTS + 1));
+    for (uint32_t hash = 1; hash <= SLOTS; hash++) {
+        CHECK_EQUAL(hash + 100, lookup(hash));
+    }
+    // A code already there still gets a new action
+    CHECK(IR_learnedInsert(hashes, actions, SLOTS, SLOTS, 7));
+    CHECK_EQUAL(7, lookup(SLOTS));
+}
+
+// Inserting a code again changes its action and takes no other slot
+static void testDuplicateInsert(void) {
+    clearTable();
+    CHECK(IR_learnedInsert(hashes, actions, SLOTS, 0x12345678, 1));
+    CHECK(IR_learnedInsert(hashes, actions, SLOTS, 0x12345678, 2));
+    CHECK_EQUAL(1, usedSlots());
+    CHECK_EQUAL(2, lookup(0x12345678));
+}
+
+// IR_LEARNED_EMPTY marks unused slots, it can be neither learned nor found
+static void testEmptyHash(void) {
+    clearTable();
+    CHECK(!IR_learnedInsert(hashes, actions, SLOTS, IR_LEARNED_EMPTY, 1));
+    CHECK_EQUAL(0, usedSlots());
+    CHECK_EQUAL(IR_LEARNED_NONE, lookup(IR_LEARNED_EMPTY));
+    // Neither a slot count which is no power of two
+    CHECK(!IR_learnedInsert(hashes, actions, 6, 1, 1));
+    CHECK(!IR_learnedInsert(hashes, actions, 0, 1, 1));
+}
+
+// Lengths 15 and 31 share the last bucket, 16 is in the first and 17 in the second
+static void testBucketBoundaries(void) {
+    static const uint16_t durations[32];
+    static const ir_template_t templates[] = {
+        { durations, 15, 0 },
+        { durations, 16, 1 },
+        { durations, 31, 2 },
+        { durations, 17, 3 },
+        { durations, 32, 4 },
+    };
+    static uint16_t order[5];
+    ir_template_set_t set = { templates, 5, 0, order, { 0 } };
+
+    IR_templateIndex(&set);
+    CHECK_EQUAL(0, set.first[0]);
+    CHECK_EQUAL(2, set.first[1]);
+    CHECK_EQUAL(3, set.first[2]);
+    CHECK_EQUAL(3, set.first[IR_TEMPLATE_BUCKETS - 1]);
+    CHECK_EQUAL(5, set.first[IR_TEMPLATE_BUCKETS]);
+    // Within a bucket the templates keep their order
+    CHECK_EQUAL(1, order[0]);
+    CHECK_EQUAL(4, order[1]);
+    CHECK_EQUAL(3, order[2]);
+    CHECK_EQUAL(0, order[3]);
+    CHECK_EQUAL(2, order[4]);
+
+    setFrame(durations, 15);
+    CHECK_EQUAL(0, match(&set));
+    setFrame(durations, 16);
+    CHECK_EQUAL(1, match(&set));
+    setFrame(durations, 17);
+    CHECK_EQUAL(3, match(&set));
+    setFrame(durations, 31);
+    CHECK_EQUAL(2, match(&set));
+    // The last bucket holds no template of length 47
+    setFrame(durations, 47);
+    CHECK_EQUAL(IR_LEARNED_NONE, match(&set));
+}
+
+// The closest template wins, one which reaches the best distance on the way is not taken
+static void testClosestAndBound(void) {
+    static const uint16_t frame[] = { 1000, 1000, 1000, 1000 };
+    static const uint16_t far[] = { 1100, 1000, 1000, 1000 };     // distance 100
+    static const uint16_t near[] = { 1000, 1000, 1000, 1050 };    // distance 50
+    static const uint16_t early[] = { 1050, 1000, 1000, 1000 };   // distance 50 at once
+    static const ir_template_t templates[] = {
+        { far, 4, 1 },
+        { near, 4, 2 },
+        { early, 4, 3 },
+    };
+    static uint16_t order[3];
+    ir_template_set_t set = { templates, 3, 0, order, { 0 } };
+
+    IR_templateIndex(&set);
+    setFrame(frame, 4);
+    CHECK_EQUAL(2, match(&set));
+
+    // An exact template ends the search
+    setFrame(near, 4);
+    CHECK_EQUAL(2, match(&set));
+}
+
+// Deviations within TOLERANCE only rank, those beyond it are summed up against maxExcess
+static void testMaxExcess(void) {
+    static const uint16_t durations[] = { 1000, 1000, 1000, 1000 };
+    static const uint16_t jitter[] = { 1240, 760, 1240, 760 };    // within 25%
+    static const uint16_t beyond[] = { 1300, 1000, 1000, 1300 };  // 50 beyond 25% twice
+    static const ir_template_t templates[] = {
+        { durations, 4, 1 },
+    };
+    static uint16_t order[1];
+    ir_template_set_t set = { templates, 1, 0, order, { 0 } };
+
+    IR_templateIndex(&set);
+    setFrame(jitter, 4);
+    CHECK_EQUAL(1, match(&set));
+
+    setFrame(beyond, 4);
+    CHECK_EQUAL(IR_LEARNED_NONE, match(&set));
+    set.maxExcess = 99;
+    CHECK_EQUAL(IR_LEARNED_NONE, match(&set));
+    set.maxExcess = 100;
+    CHECK_EQUAL(1, match(&set));
+
+    // An overflowed frame never matches
+    results.overflow = true;
+    CHECK_EQUAL(IR_LEARNED_NONE, match(&set));
+}
+
+int main(void) {
+    RUN_TEST(testProbeWraparound);
+    RUN_TEST(testFullTable);
+    RUN_TEST(testDuplicateInsert);
+    RUN_TEST(testEmptyHash);
+    RUN_TEST(testBucketBoundaries);
+    RUN_TEST(testClosestAndBound);
+    RUN_TEST(testMaxExcess);
+    return TEST_RESULT();
+}
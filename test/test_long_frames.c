@@ -0,0 +1,124 @@
+/**
+ * @file test_long_frames.c
+ * @brief USE_IR_LONG_FRAMES: frames far longer than the edge FIFO are decoded by the ISR.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+#define AC_HEADER_MARK  3400
+#define AC_HEADER_SPACE 1750
+#define AC_BIT_MARK     450
+#define AC_ONE_SPACE    1300
+#define AC_ZERO_SPACE   420
+
+// Air conditioner state frames of 100 bits and more, reported as UNUSED
+static const ir_protocol_t acProtocol = {
+    .decode_type = UNUSED,
+    .headerMark = IR_MARK_TICKS(AC_HEADER_MARK),
+    .headerSpace = IR_SPACE_TICKS(AC_HEADER_SPACE),
+    .repeatSpace = IR_NO_TICKS,
+    .bitMark = IR_MARK_TICKS(AC_BIT_MARK),
+    .oneSpace = IR_SPACE_TICKS(AC_ONE_SPACE),
+    .zeroSpace = IR_SPACE_TICKS(AC_ZERO_SPACE),
+    .bits = 100,
+    .addressBits = 0,
+    .flags = IR_PROTOCOL_MSB_FIRST | IR_PROTOCOL_STOP_BIT,
+};
+
+static ir_decode_results results;
+static uint8_t state[38];
+static uint8_t sent[38];
+
+static void start(void) {
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_setLongFrames(&acProtocol, state, sizeof(state));
+    IR_mockSpace(20000);
+}
+
+// The whole frame arrives before the decoder task gets to drain the FIFO
+static void sendFrame(uint16_t bits, uint8_t seed) {
+    for (uint8_t i = 0; i < sizeof(sent); i++) {
+        sent[i] = (uint8_t)(seed + 37 * i);
+    }
+    IR_mockPulseDistance(AC_HEADER_MARK, AC_HEADER_SPACE, AC_BIT_MARK, AC_ONE_SPACE, AC_ZERO_SPACE, bits, sent);
+    IR_mockSpace(40000);
+}
+
+// Checks the frame against sent, the unused bits of the last byte are zero
+static void checkLongFrame(uint16_t bits) {
+    CHECK(IR_decode(&results));
+    CHECK_EQUAL(UNUSED, results.decode_type);
+    CHECK_EQUAL(bits, results.bits);
+    CHECK(results.data == state);
+    for (uint16_t i = 0; i < (bits + 7) / 8; i++) {
+        uint8_t mask = i < bits / 8 ? 0xFF : (uint8_t)(0xFF << (8 - bits % 8));
+        CHECK_EQUAL(sent[i] & mask, state[i]);
+    }
+    IR_resume();
+}
+
+static void testLengths(void) {
+    static const uint16_t lengths[] = { 126, 200, 300 };
+    ir_receiver_stats_t stats;
+
+    start();
+    for (uint8_t k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++) {
+        sendFrame(lengths[k], k);
+        checkLongFrame(lengths[k]);
+    }
+    CHECK(!IR_decode(&results));
+    IR_getStats(&stats);
+    CHECK_EQUAL(3, stats.frames);
+    CHECK_EQUAL(0, stats.overruns);
+    CHECK_EQUAL(3, stats.decoded[UNUSED]);
+}
+
+// Other frames still go through the FIFO and the decoders
+static void testShortFrames(void) {
+    start();
+    IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, 0x20DF10EF);
+    IR_mockSpace(40000);
+    sendFrame(200, 1);
+    IR_mockPulseDistance32(9000, 4500, 560, 1690, 560, 32, 0x20DF40BF);
+    IR_mockSpace(40000);
+
+    CHECK(IR_decode(&results));
+    CHECK_EQUAL(NEC, results.decode_type);
+    CHECK_EQUAL(0x20DF10EF, results.value);
+    IR_resume();
+    checkLongFrame(200);
+    CHECK(IR_decode(&results));
+    CHECK_EQUAL(NEC, results.decode_type);
+    CHECK_EQUAL(0x20DF40BF, results.value);
+    IR_resume();
+}
+
+// The ISR keeps the buffer until IR_resume(), a second long frame meanwhile is only received raw
+static void testHeldUntilResume(void) {
+    start();
+    sendFrame(126, 2);
+    uint8_t first[sizeof(sent)];
+    memcpy(first, sent, sizeof(first));
+    sendFrame(126, 3);
+
+    CHECK(IR_decode(&results));
+    CHECK_EQUAL(UNUSED, results.decode_type);
+    CHECK_EQUAL(0, memcmp(first, state, 126 / 8));
+    IR_resume();
+    if (IR_decode(&results)) {
+        CHECK(results.decode_type != UNUSED);
+        IR_resume();
+    }
+
+    sendFrame(300, 4);
+    checkLongFrame(300);
+}
+
+int main(void) {
+    RUN_TEST(testLengths);
+    RUN_TEST(testShortFrames);
+    RUN_TEST(testHeldUntilResume);
+    return TEST_RESULT();
+}
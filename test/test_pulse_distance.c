@@ -0,0 +1,174 @@
+/**
+ * @file test_pulse_distance.c
+ * @brief The word parallel pulse distance loop decodes like the entry by entry loop it replaced.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+#define FRAMES 20000
+
+static irraw_t rawbuf[RAW_BUFFER_LENGTH];
+static ir_decode_results results;
+static uint32_t seed = 12345;
+
+static uint32_t randomNumber(void) {
+    seed = seed * 1103515245UL + 12345;
+    return seed >> 8;
+}
+
+/*
+ * The loops before the SWAR one: each mark and space is matched on its own,
+ * a 1 space is tried first, LSB first frames are collected with a mask.
+ */
+static bool referenceDecode(uint8_t aNumberOfBits, uint8_t aStartOffset, unsigned int aBitMarkMicros,
+        unsigned int aOneSpaceMicros, unsigned int aZeroSpaceMicros, bool aMSBfirst, uint32_t *aValue) {
+    ir_ticks_t bitMark = IR_MARK_TICKS(aBitMarkMicros);
+    ir_ticks_t oneSpace = IR_SPACE_TICKS(aOneSpaceMicros);
+    ir_ticks_t zeroSpace = IR_SPACE_TICKS(aZeroSpaceMicros);
+    uint32_t tDecodedData = 0;
+    uint32_t mask = 1;
+
+    for (uint8_t i = 0; i < aNumberOfBits; i++, mask <<= 1) {
+        if (!IR_matchTicks(IR_RAW(&results, aStartOffset), &bitMark)) {
+            return false;
+        }
+        aStartOffset++;
+        bool one = IR_matchTicks(IR_RAW(&results, aStartOffset), &oneSpace);
+        if (!one && !IR_matchTicks(IR_RAW(&results, aStartOffset), &zeroSpace)) {
+            return false;
+        }
+        aStartOffset++;
+        if (aMSBfirst) {
+            tDecodedData = (tDecodedData << 1) | one;
+        } else if (one) {
+            tDecodedData |= mask;
+        }
+    }
+    *aValue = tDecodedData;
+    return true;
+}
+
+typedef struct {
+    uint16_t bitMark;
+    uint16_t oneSpace;
+    uint16_t zeroSpace;
+} timing_t;
+
+// NEC, JVC, Denon, Lego PF, MagiQuest, and one with overlapping spaces
+static const timing_t timings[] = {
+    { 560, 1690, 560 },
+    { 525, 1575, 525 },
+    { 260, 1820, 780 },
+    { 158, 553, 263 },
+    { 280, 850, 280 },
+    { 500, 1000, 900 },
+};
+
+// Duration around us, mostly within TOLERANCE, sometimes beyond it or beyond a lane
+static uint16_t jitter(uint16_t us) {
+    uint32_t r = randomNumber();
+
+    switch (r % 128) {
+    case 0:
+        return 0x7FFF + (r >> 7) % 0x8001;
+    case 1:
+        return (r >> 7) % 0x10000;
+    default:
+        // -28% .. +28%, around the edges of TOLERANCE
+        return (uint32_t) us * (72 + (r >> 7) % 57) / 100 / MICROS_PER_TICK;
+    }
+}
+
+static void setFrame(const timing_t *timing, uint8_t bits) {
+    memset(&results, 0, sizeof(results));
+    results.rawbuf = rawbuf;
+    rawbuf[0] = 50000;
+    for (uint8_t i = 0; i < bits; i++) {
+        rawbuf[1 + 2 * i] = jitter(timing->bitMark + MARK_EXCESS_MICROS);
+        rawbuf[2 + 2 * i] = jitter(((randomNumber() & 1) ? timing->oneSpace : timing->zeroSpace) - MARK_EXCESS_MICROS);
+    }
+    results.rawlen = 1 + 2 * bits;
+}
+
+// Random frames of 0 to 32 bits in both bit orders, jittered and damaged
+static void testEquivalence(void) {
+    uint32_t mismatches = 0;
+    uint32_t decoded = 0;
+
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        const timing_t *timing = &timings[randomNumber() % (sizeof(timings) / sizeof(timings[0]))];
+        uint8_t bits = randomNumber() % 33;
+        bool msbFirst = randomNumber() & 1;
+        uint32_t expected = 0;
+
+        setFrame(timing, bits);
+        bool ok = referenceDecode(bits, 1, timing->bitMark, timing->oneSpace, timing->zeroSpace, msbFirst, &expected);
+        results.value = 0xDEADBEEF;
+        if (IR_decodePulseDistanceData(&results, bits, 1, timing->bitMark, timing->oneSpace, timing->zeroSpace, msbFirst) != ok
+                || (ok && results.value != expected)) {
+            if (mismatches++ == 0) {
+                printf("frame %lu: %u bits %s, expected %d 0x%08lX\n", (unsigned long) n, bits,
+                        msbFirst ? "MSB" : "LSB", ok, (unsigned long) expected);
+            }
+        }
+        decoded += ok;
+    }
+    CHECK_EQUAL(0, mismatches);
+    // Both outcomes are covered
+    CHECK(decoded > FRAMES / 10);
+    CHECK(decoded < FRAMES - FRAMES / 10);
+}
+
+// LSB first frames are reversed within their bits, 0 bits leave a 0
+static void testBitOrder(void) {
+    static const timing_t nec = { 560, 1690, 560 };
+
+    for (uint8_t bits = 0; bits <= 32; bits++) {
+        uint32_t pattern = 0xC5A3E817UL & (bits < 32 ? (1UL << bits) - 1 : 0xFFFFFFFFUL);
+
+        memset(&results, 0, sizeof(results));
+        results.rawbuf = rawbuf;
+        for (uint8_t i = 0; i < bits; i++) {
+            rawbuf[1 + 2 * i] = 560 / MICROS_PER_TICK;
+            rawbuf[2 + 2 * i] = ((pattern >> i) & 1 ? 1690 : 560) / MICROS_PER_TICK;
+        }
+        results.rawlen = 1 + 2 * bits;
+        results.value = 0xDEADBEEF;
+        CHECK(IR_decodePulseDistanceData(&results, bits, 1, nec.bitMark, nec.oneSpace, nec.zeroSpace, false));
+        CHECK_EQUAL(pattern, results.value);
+    }
+}
+
+// A lane holds 15 bits, longer durations never match instead of aliasing into a shorter one
+static void testLaneLimit(void) {
+    uint32_t expected = 0;
+
+    memset(&results, 0, sizeof(results));
+    results.rawbuf = rawbuf;
+    results.rawlen = 3;
+
+    // 0x8000 + 560 must not pass for a 560 us mark
+    rawbuf[1] = 0x8000 + 560 / MICROS_PER_TICK;
+    rawbuf[2] = 560 / MICROS_PER_TICK;
+    CHECK(!IR_decodePulseDistanceData(&results, 1, 1, 560, 1690, 560, true));
+    rawbuf[1] = 560 / MICROS_PER_TICK;
+    rawbuf[2] = 0x8000 + 1690 / MICROS_PER_TICK;
+    CHECK(!IR_decodePulseDistanceData(&results, 1, 1, 560, 1690, 560, true));
+
+    // Unlike the old loop, a duration above 0x7FFF ticks does not match even if its range covers it
+#if MICROS_PER_TICK == 1
+    rawbuf[1] = 40000;
+    rawbuf[2] = 40000;
+    CHECK(referenceDecode(1, 1, 40000, 40000, 1000, true, &expected));
+    CHECK(!IR_decodePulseDistanceData(&results, 1, 1, 40000, 40000, 1000, true));
+#endif
+    (void) expected;
+}
+
+int main(void) {
+    RUN_TEST(testEquivalence);
+    RUN_TEST(testBitOrder);
+    RUN_TEST(testLaneLimit);
+    return TEST_RESULT();
+}
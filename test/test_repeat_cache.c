@@ -0,0 +1,132 @@
+/**
+ * @file test_repeat_cache.c
+ * @brief IR_REPEAT_CACHE_MS: which frames of a held key are answered from the cache.
+ */
+#include "IRremote.h"
+#include "ir_mock.h"
+#include "ir_test.h"
+
+static ir_decode_results results;
+
+static void start(void) {
+    IR_mockReset(0);
+    IR_enableIRIn();
+    IR_mockSpace(100000);
+}
+
+// Decodes the next frame, the type is 0 if there is none
+static ir_decode_type_t decodeNext(void) {
+    memset(&results, 0, sizeof(results));
+    if (!IR_decode(&results)) {
+        return 0;
+    }
+    IR_resume();
+    return results.decode_type;
+}
+
+static uint32_t cachedFrames(void) {
+    ir_receiver_stats_t stats;
+    IR_getStats(&stats);
+    return stats.cached;
+}
+
+static void sendJVC(uint16_t value, uint32_t gap) {
+    IR_mockPulseDistance32(8400, 4200, 525, 1575, 525, 16, value);
+    IR_mockSpace(gap);
+}
+
+// 15 bits LSB first: address, command, expansion and check bit, no header
+static void sendSharpAlt(uint16_t bits, uint32_t gap) {
+    uint16_t reversed = 0;
+
+    for (uint8_t i = 0; i < 15; i++) {
+        reversed = (reversed << 1) | ((bits >> i) & 1);
+    }
+    IR_mockPulseDistance32(0, 0, 150, 1750, 700, 15, reversed);
+    IR_mockSpace(gap);
+}
+
+// The same frame again within IR_REPEAT_CACHE_MS is a hit, another one a miss
+static void testHitAndMiss(void) {
+    start();
+    sendJVC(0xC5E8, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK(!results.isRepeat);
+    CHECK_EQUAL(0, cachedFrames());
+
+    sendJVC(0xC5E8, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK(results.isRepeat);
+    CHECK_EQUAL(0xC5E8, results.value);
+    CHECK_EQUAL(1, cachedFrames());
+
+    sendJVC(0xC5E9, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK(!results.isRepeat);
+    CHECK_EQUAL(0xC5E9, results.value);
+    CHECK_EQUAL(1, cachedFrames());
+
+    // The miss is the new cached frame
+    sendJVC(0xC5E9, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK(results.isRepeat);
+    CHECK_EQUAL(0xC5E9, results.value);
+    CHECK_EQUAL(2, cachedFrames());
+}
+
+// A frame after IR_REPEAT_CACHE_MS is decoded again, even if it is the same
+static void testExpiry(void) {
+    start();
+    sendJVC(0xC5E8, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    IR_mockSpace(IR_REPEAT_CACHE_MS * 1000);
+
+    sendJVC(0xC5E8, 50000);
+    CHECK_EQUAL(JVC, decodeNext());
+    CHECK(!results.isRepeat);
+    CHECK_EQUAL(0, cachedFrames());
+}
+
+// Hashed frames are never cached, every one of them is hashed again
+static void testUnknownNotCached(void) {
+    start();
+    for (uint8_t i = 0; i < 3; i++) {
+        IR_mockPulseDistance32(6000, 3000, 1000, 3000, 2000, 8, 0xA5);
+        IR_mockSpace(50000);
+        CHECK_EQUAL(UNKNOWN, decodeNext());
+        CHECK(!results.isRepeat);
+    }
+    CHECK_EQUAL(0, cachedFrames());
+}
+
+// Sharp Alt sends a frame, the inverted frame and the frame again, 44 ms apart.
+// The decoder ignores the first repeat after the inverted frame by the gap and its
+// state, so none of them may come from the cache.
+static void testSharpAlt(void) {
+    const uint16_t frame = 0x2000 | (0x5A << 5) | 0x11;    // expansion bit, command, address
+
+    start();
+    sendSharpAlt(frame, 44000);
+    CHECK_EQUAL(SHARP_ALT, decodeNext());
+    CHECK_EQUAL(0x5A, results.value);
+
+    sendSharpAlt(frame ^ 0x7FE0, 44000);
+    CHECK(decodeNext() != SHARP_ALT);
+
+    sendSharpAlt(frame, 44000);
+    CHECK(decodeNext() != SHARP_ALT);
+
+    sendSharpAlt(frame, 44000);
+    CHECK_EQUAL(SHARP, decodeNext());
+    CHECK(results.isRepeat);
+    CHECK_EQUAL(REPEAT, results.value);
+    CHECK_EQUAL(0, cachedFrames());
+}
+
+int main(void) {
+    RUN_TEST(testHitAndMiss);
+    RUN_TEST(testExpiry);
+    RUN_TEST(testUnknownNotCached);
+    RUN_TEST(testSharpAlt);
+    return TEST_RESULT();
+}